@@ -1,7 +1,13 @@
 #include "../src/EmeraldsTable.h"
 
+#define c89_hash(key) ((size_t)(key) * 0x9e3779b97f4a7c15)
+#define c89_eq(a, b)  ((a) == (b))
+
+TABLE_DEFINE(C89IntTable, c89_int_table, size_t, int, c89_hash, c89_eq);
+
 int main(void) {
   EmeraldsTable table = {0};
+  C89IntTable ints    = {0};
   table_init(&table);
   table_add(&table, "key1", 100);
   table_add(&table, "key2", 200);
@@ -16,4 +22,10 @@ int main(void) {
   table_get(&table, "key2");
 
   table_deinit(&table);
+
+  c89_int_table_init(&ints);
+  c89_int_table_add(&ints, 1, 10);
+  (void)c89_int_table_get(&ints, 1);
+  c89_int_table_remove(&ints, 1);
+  c89_int_table_deinit(&ints);
 }
@@ -1,14 +1,52 @@
 #include "../libs/cSpec/export/cSpec.h"
+#include "concurrent_table/concurrent_table.module.spec.h"
+#include "frozen_table/frozen_table.module.spec.h"
 #include "hash/komihash/komihash.module.spec.h"
 #include "hash/xxh3/xxh3.module.spec.h"
+#include "int_table/benchmarks/int_table_benchmark.spec.h"
+#include "int_table/int_table.module.spec.h"
+#include "mapped_table/mapped_table.module.spec.h"
+#include "rcu_table/benchmarks/rcu_table_benchmark.spec.h"
+#include "rcu_table/rcu_table.module.spec.h"
+#include "sharded_table/benchmarks/sharded_table_benchmark.spec.h"
+#include "sharded_table/sharded_table.module.spec.h"
 #include "table/benchmarks/table_general_benchmark.spec.h"
+#include "table/benchmarks/table_growth_benchmark.spec.h"
+#include "table/benchmarks/table_latency_benchmark.spec.h"
+#include "table/benchmarks/table_rehash_benchmark.spec.h"
+#include "table/benchmarks/table_scope_chain_benchmark.spec.h"
+#include "table/benchmarks/table_small_benchmark.spec.h"
 #include "table/table.module.spec.h"
+#include "table_pages/benchmarks/table_pages_benchmark.spec.h"
+#include "table_pages/table_pages.module.spec.h"
+#include "table_pool/benchmarks/table_pool_benchmark.spec.h"
+#include "table_pool/table_pool.module.spec.h"
+#include "typed_table/typed_table.module.spec.h"
 
 int main(void) {
   cspec_run_suite("all", {
     T_komihash();
     T_xxh3();
     T_table_general_benchmark();
+    T_table_growth_benchmark();
+    T_table_latency_benchmark();
+    T_table_rehash_benchmark();
+    T_table_scope_chain_benchmark();
+    T_table_small_benchmark();
+    T_table_pages_benchmark();
+    T_table_pool_benchmark();
+    T_int_table_benchmark();
+    T_rcu_table_benchmark();
+    T_sharded_table_benchmark();
     T_table();
+    T_table_pages();
+    T_table_pool();
+    T_typed_table();
+    T_int_table();
+    T_frozen_table();
+    T_mapped_table();
+    T_rcu_table();
+    T_concurrent_table();
+    T_sharded_table();
   });
 }
@@ -0,0 +1,190 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+#include <pthread.h>
+
+#if defined(CONCURRENT_TABLE_AVAILABLE)
+
+  #define CONCURRENT_TABLE_SPEC_THREADS (4)
+  #define CONCURRENT_TABLE_SPEC_KEYS    (50000)
+
+static char concurrent_table_spec_keys[CONCURRENT_TABLE_SPEC_THREADS]
+                                      [CONCURRENT_TABLE_SPEC_KEYS][16];
+static EmeraldsConcurrentTable concurrent_table_spec_table;
+
+/* Every writer owns its keys, all of them share the resizes */
+static void *concurrent_table_spec_writer(void *arg) {
+  size_t thread = (size_t)arg;
+  char(*keys)[16] = concurrent_table_spec_keys[thread];
+
+  for(size_t i = 0; i < CONCURRENT_TABLE_SPEC_KEYS; i++) {
+    concurrent_table_add(&concurrent_table_spec_table, keys[i], i);
+    if(i % 4 == 0) {
+      concurrent_table_add(&concurrent_table_spec_table, keys[i / 2], i + 1);
+    }
+    if(i % 5 == 0) {
+      concurrent_table_remove(&concurrent_table_spec_table, keys[i / 3]);
+      concurrent_table_add(&concurrent_table_spec_table, keys[i / 3], i / 3);
+    }
+  }
+  for(size_t i = 0; i < CONCURRENT_TABLE_SPEC_KEYS; i += 2) {
+    concurrent_table_remove(&concurrent_table_spec_table, keys[i]);
+  }
+  return NULL;
+}
+
+  #define CONCURRENT_TABLE_SPEC_CHURN (200000)
+
+static char (*concurrent_table_spec_churn_keys)[16];
+
+/* Adds and removes distinct keys, the size stays close to zero throughout */
+static void *concurrent_table_spec_churner(void *arg) {
+  size_t thread = (size_t)arg;
+  for(size_t i = 0; i < CONCURRENT_TABLE_SPEC_CHURN; i++) {
+    const char *key = concurrent_table_spec_churn_keys
+      [thread * CONCURRENT_TABLE_SPEC_CHURN + i];
+    concurrent_table_add(&concurrent_table_spec_table, key, i);
+    concurrent_table_remove(&concurrent_table_spec_table, key);
+  }
+  return NULL;
+}
+
+/* Arrays still allocated, the published one and every one chained to it */
+static size_t concurrent_table_spec_generations(EmeraldsConcurrentTable *self) {
+  size_t count                       = 0;
+  EmeraldsConcurrentBuckets *buckets = atomic_load(&self->generations);
+  while(buckets != NULL) {
+    count++;
+    buckets = atomic_load(&buckets->next);
+  }
+  return count;
+}
+
+module(T_concurrent_table, {
+  it("inserts, updates and removes from a single thread", {
+    EmeraldsConcurrentTable table;
+    char keys[5000][16];
+    concurrent_table_init(&table);
+
+    concurrent_table_add(&table, "key1", 1);
+    concurrent_table_add(&table, "key2", 2);
+    concurrent_table_add(&table, "key1", 10);
+    assert_that_size_t(concurrent_table_size(&table) equals to 2);
+    assert_that_size_t(concurrent_table_get(&table, "key1") equals to 10);
+
+    concurrent_table_remove(&table, "key1");
+    concurrent_table_remove(&table, "absent");
+    assert_that_size_t(
+      concurrent_table_get(&table, "key1") equals to TABLE_UNDEFINED
+    );
+    assert_that_size_t(concurrent_table_size(&table) equals to 1);
+
+    for(size_t i = 0; i < 5000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "key_%zu", i);
+      concurrent_table_add(&table, keys[i], i);
+    }
+    assert_that_size_t(concurrent_table_size(&table) equals to 5001);
+    assert_that_size_t(concurrent_table_get(&table, "key_4999") equals to 4999);
+    assert_that_size_t(concurrent_table_get(&table, "key2") equals to 2);
+
+    concurrent_table_deinit(&table);
+  });
+
+  it("keeps every key while several writers resize the table", {
+    pthread_t writers[CONCURRENT_TABLE_SPEC_THREADS];
+
+    concurrent_table_init(&concurrent_table_spec_table);
+    for(size_t t = 0; t < CONCURRENT_TABLE_SPEC_THREADS; t++) {
+      for(size_t i = 0; i < CONCURRENT_TABLE_SPEC_KEYS; i++) {
+        snprintf(concurrent_table_spec_keys[t][i], 16, "c%zu_%zu", t, i);
+      }
+      pthread_create(
+        &writers[t], NULL, concurrent_table_spec_writer, (void *)t
+      );
+    }
+    for(size_t t = 0; t < CONCURRENT_TABLE_SPEC_THREADS; t++) {
+      pthread_join(writers[t], NULL);
+    }
+
+    size_t errors = 0;
+    for(size_t t = 0; t < CONCURRENT_TABLE_SPEC_THREADS; t++) {
+      for(size_t i = 0; i < CONCURRENT_TABLE_SPEC_KEYS; i++) {
+        size_t value = concurrent_table_get(
+          &concurrent_table_spec_table, concurrent_table_spec_keys[t][i]
+        );
+        /* Updates only touch even keys, which end up removed */
+        size_t expected = i % 2 == 0 ? TABLE_UNDEFINED : i;
+        errors += value != expected;
+      }
+    }
+    assert_that_size_t(errors equals to 0);
+    assert_that_size_t(
+      concurrent_table_size(&concurrent_table_spec_table) equals to
+        CONCURRENT_TABLE_SPEC_THREADS * CONCURRENT_TABLE_SPEC_KEYS / 2
+    );
+
+    concurrent_table_deinit(&concurrent_table_spec_table);
+  });
+
+  it("frees the arrays that churn retires", {
+    pthread_t churners[CONCURRENT_TABLE_SPEC_THREADS];
+    size_t most_generations = 0;
+    concurrent_table_spec_churn_keys = malloc(
+      CONCURRENT_TABLE_SPEC_THREADS * CONCURRENT_TABLE_SPEC_CHURN *
+      sizeof(*concurrent_table_spec_churn_keys)
+    );
+    for(size_t i = 0;
+        i < CONCURRENT_TABLE_SPEC_THREADS * CONCURRENT_TABLE_SPEC_CHURN;
+        i++) {
+      snprintf(concurrent_table_spec_churn_keys[i], 16, "churn_%zu", i);
+    }
+
+    /* One thread, every resize reuses the same capacity */
+    concurrent_table_init(&concurrent_table_spec_table);
+    for(size_t i = 0; i < CONCURRENT_TABLE_SPEC_CHURN; i++) {
+      const char *key = concurrent_table_spec_churn_keys[i];
+      concurrent_table_add(&concurrent_table_spec_table, key, i);
+      concurrent_table_remove(&concurrent_table_spec_table, key);
+      size_t generations =
+        concurrent_table_spec_generations(&concurrent_table_spec_table);
+      if(generations > most_generations) {
+        most_generations = generations;
+      }
+    }
+    assert_that_size_t(
+      concurrent_table_size(&concurrent_table_spec_table) equals to 0
+    );
+    assert_that(most_generations <= 3);
+    assert_that_size_t(
+      atomic_load(&concurrent_table_spec_table.buckets)->capacity equals to
+        TABLE_INITIAL_SIZE
+    );
+    concurrent_table_deinit(&concurrent_table_spec_table);
+
+    /* Several threads, retired arrays wait until no operation can see them */
+    concurrent_table_init(&concurrent_table_spec_table);
+    for(size_t t = 0; t < CONCURRENT_TABLE_SPEC_THREADS; t++) {
+      pthread_create(
+        &churners[t], NULL, concurrent_table_spec_churner, (void *)t
+      );
+    }
+    for(size_t t = 0; t < CONCURRENT_TABLE_SPEC_THREADS; t++) {
+      pthread_join(churners[t], NULL);
+    }
+    assert_that_size_t(
+      concurrent_table_size(&concurrent_table_spec_table) equals to 0
+    );
+    /* Lookups advance the epochs the last writers left arrays behind in */
+    concurrent_table_get(&concurrent_table_spec_table, "churn_0");
+    concurrent_table_get(&concurrent_table_spec_table, "churn_0");
+    assert_that(
+      concurrent_table_spec_generations(&concurrent_table_spec_table) <= 2
+    );
+    concurrent_table_deinit(&concurrent_table_spec_table);
+    free(concurrent_table_spec_churn_keys);
+  });
+})
+
+#else
+module(T_concurrent_table, {});
+#endif
@@ -0,0 +1,83 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../libs/EmeraldsFileHandler/export/EmeraldsFileHandler.h"
+#include "../../libs/EmeraldsString/export/EmeraldsString.h"
+#include "../../libs/EmeraldsVector/export/EmeraldsVector.h"
+#include "../../src/EmeraldsTable.h"
+
+module(T_frozen_table, {
+  it("freezes an empty table", {
+    EmeraldsTable table        = {0};
+    EmeraldsFrozenTable frozen = {0};
+    table_init(&table);
+
+    assert_that(table_freeze(&table, &frozen));
+    assert_that_size_t(frozen_table_size(&frozen) equals to 0);
+    assert_that_size_t(
+      frozen_table_get(&frozen, "key") equals to TABLE_UNDEFINED
+    );
+
+    frozen_table_deinit(&frozen);
+    table_deinit(&table);
+  });
+
+  it("keeps exactly one slot per key", {
+    EmeraldsTable table        = {0};
+    EmeraldsFrozenTable frozen = {0};
+    table_init(&table);
+
+    table_add(&table, "", 1);
+    table_add(&table, "a", 2);
+    table_add(&table, "b", 3);
+    table_add(&table, "removed", 4);
+    table_remove(&table, "removed");
+
+    assert_that(table_freeze(&table, &frozen));
+    table_deinit(&table);
+
+    assert_that_size_t(frozen_table_size(&frozen) equals to 3);
+    assert_that_size_t(frozen_table_get(&frozen, "") equals to 1);
+    assert_that_size_t(frozen_table_get(&frozen, "a") equals to 2);
+    assert_that_size_t(frozen_table_get_n(&frozen, "bc", 1) equals to 3);
+    assert_that_size_t(
+      frozen_table_get(&frozen, "removed") equals to TABLE_UNDEFINED
+    );
+
+    frozen_table_deinit(&frozen);
+    assert_that(frozen.slots is NULL);
+    assert_that(frozen.pilots is NULL);
+  });
+
+  it("answers every key of a file with 100000 random words", {
+    EmeraldsTable table        = {0};
+    EmeraldsFrozenTable frozen = {0};
+    table_init(&table);
+
+    char *words = string_new(file_handler_read("examples/random_words.txt"));
+    char **arr  = string_split(words, '\n');
+
+    for(size_t i = 0; i < vector_size(arr); i++) {
+      table_add(&table, arr[i], i + 1);
+    }
+
+    assert_that(table_freeze(&table, &frozen));
+    assert_that_size_t(
+      frozen_table_size(&frozen) equals to table_size(&table)
+    );
+
+    size_t misses = 0;
+    for(size_t i = 0; i < vector_size(arr); i++) {
+      if(frozen_table_get(&frozen, arr[i]) != table_get(&table, arr[i])) {
+        misses++;
+      }
+    }
+    assert_that_size_t(misses equals to 0);
+    assert_that_size_t(frozen_table_get(&frozen, "bfs6Zsw") equals to 1);
+    assert_that_size_t(frozen_table_get(&frozen, "tP7hbqI") equals to 100000);
+    assert_that_size_t(
+      frozen_table_get(&frozen, "not a random word") equals to TABLE_UNDEFINED
+    );
+
+    frozen_table_deinit(&frozen);
+    table_deinit(&table);
+  });
+})
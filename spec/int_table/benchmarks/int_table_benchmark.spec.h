@@ -0,0 +1,98 @@
+#ifndef __INT_TABLE_BENCHMARK_SPEC_H_
+#define __INT_TABLE_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "../../table/benchmarks/table_general_benchmark.spec.h"
+
+#define INT_ITEM_COUNT 1000000
+
+static uint64_t int_benchmark_random() {
+  return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+static void
+int_benchmark_run(const char *name, uint64_t *ids, char (*strings)[24]) {
+  EmeraldsIntTable ints = {0};
+  EmeraldsTable table   = {0};
+  size_t found          = 0;
+  double start_time;
+
+  int_table_init(&ints);
+  start_time = get_time();
+  for(size_t i = 0; i < INT_ITEM_COUNT; i++) {
+    int_table_add(&ints, ids[i], i);
+  }
+  printf(
+    "%s: EmeraldsIntTable insertion of %d items took %f seconds.\n",
+    name,
+    INT_ITEM_COUNT,
+    get_time() - start_time
+  );
+  start_time = get_time();
+  for(size_t i = 0; i < INT_ITEM_COUNT; i++) {
+    found += int_table_get(&ints, ids[i]) != NULL;
+  }
+  printf(
+    "%s: EmeraldsIntTable lookup of %d items took %f seconds.\n",
+    name,
+    INT_ITEM_COUNT,
+    get_time() - start_time
+  );
+
+  /* The string table pays for formatting as well, just like callers do */
+  table_init(&table);
+  start_time = get_time();
+  for(size_t i = 0; i < INT_ITEM_COUNT; i++) {
+    snprintf(
+      strings[i], sizeof(strings[i]), "%llu", (unsigned long long)ids[i]
+    );
+    table_add(&table, strings[i], i);
+  }
+  printf(
+    "%s: EmeraldsTable (formatted) insertion of %d items took %f seconds.\n",
+    name,
+    INT_ITEM_COUNT,
+    get_time() - start_time
+  );
+  start_time = get_time();
+  for(size_t i = 0; i < INT_ITEM_COUNT; i++) {
+    char key[24];
+    snprintf(key, sizeof(key), "%llu", (unsigned long long)ids[i]);
+    found += table_get(&table, key) != TABLE_UNDEFINED;
+  }
+  printf(
+    "%s: EmeraldsTable (formatted) lookup of %d items took %f seconds.\n",
+    name,
+    INT_ITEM_COUNT,
+    get_time() - start_time
+  );
+
+  assert_that_size_t(found equals to 2 * INT_ITEM_COUNT);
+  int_table_deinit(&ints);
+  table_deinit(&table);
+}
+
+module(T_int_table_benchmark, {
+  it("benchmarks integer keys against formatted string keys", {
+    uint64_t *ids      = malloc(sizeof(uint64_t) * INT_ITEM_COUNT);
+    char(*strings)[24] = malloc(24 * INT_ITEM_COUNT);
+
+    printf("RUNNING INTEGER KEY BENCHMARKS\n");
+
+    for(size_t i = 0; i < INT_ITEM_COUNT; i++) {
+      ids[i] = i;
+    }
+    int_benchmark_run("Sequential", ids, strings);
+
+    for(size_t i = 0; i < INT_ITEM_COUNT; i++) {
+      ids[i] = int_benchmark_random();
+    }
+    int_benchmark_run("Random", ids, strings);
+
+    free(strings);
+    free(ids);
+  });
+})
+
+#endif
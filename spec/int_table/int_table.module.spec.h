@@ -0,0 +1,72 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+module(T_int_table, {
+  it("mixes integers bijectively", {
+    assert_that_size_t(int_table_mix(0) equals to 0);
+    assert_that(int_table_mix(1) isnot int_table_mix(2));
+    assert_that((int_table_mix(1) & 1023) isnot(int_table_mix(2) & 1023));
+  });
+
+  it("maps sequential and sparse integer ids", {
+    EmeraldsIntTable table = {0};
+    int_table_init(&table);
+
+    for(uint64_t i = 0; i < 100000; i++) {
+      int_table_add(&table, i, (size_t)i + 1);
+    }
+    int_table_add(&table, 0xffffffffffffffff, 7);
+
+    assert_that_size_t(int_table_size(&table) equals to 100001);
+    assert_that_size_t(*int_table_get(&table, 0) equals to 1);
+    assert_that_size_t(*int_table_get(&table, 99999) equals to 100000);
+    assert_that_size_t(*int_table_get(&table, 0xffffffffffffffff) equals to 7);
+    assert_that(int_table_get(&table, 100000) is NULL);
+
+    int_table_remove(&table, 500);
+    assert_that(int_table_get(&table, 500) is NULL);
+    assert_that_size_t(*int_table_get(&table, 501) equals to 502);
+
+    int_table_deinit(&table);
+  });
+
+  it("stays at its size under insert and remove churn", {
+    EmeraldsIntTable table = {0};
+    int_table_init(&table);
+
+    /* 100 live keys while a million distinct ones pass through */
+    for(uint64_t i = 0; i < 1000000; i++) {
+      int_table_add(&table, i, (size_t)i);
+      if(i >= 100) {
+        int_table_remove(&table, i - 100);
+      }
+    }
+
+    assert_that_size_t(int_table_size(&table) equals to 100);
+    assert_that_size_t(table.capacity equals to TABLE_INITIAL_SIZE);
+    assert_that_size_t(*int_table_get(&table, 999999) equals to 999999);
+    assert_that(int_table_get(&table, 999899) is NULL);
+
+    int_table_deinit(&table);
+  });
+
+  it("maps pointers to metadata", {
+    EmeraldsPointerTable table = {0};
+    int objects[64];
+    pointer_table_init(&table);
+
+    for(size_t i = 0; i < 64; i++) {
+      pointer_table_add(&table, &objects[i], i);
+    }
+
+    assert_that_size_t(*pointer_table_get(&table, &objects[0]) equals to 0);
+    assert_that_size_t(*pointer_table_get(&table, &objects[63]) equals to 63);
+    assert_that(pointer_table_get(&table, NULL) is NULL);
+
+    pointer_table_remove(&table, &objects[10]);
+    assert_that(pointer_table_get(&table, &objects[10]) is NULL);
+    assert_that_size_t(pointer_table_size(&table) equals to 63);
+
+    pointer_table_deinit(&table);
+  });
+})
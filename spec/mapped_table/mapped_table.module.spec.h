@@ -0,0 +1,153 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../libs/EmeraldsFileHandler/export/EmeraldsFileHandler.h"
+#include "../../libs/EmeraldsString/export/EmeraldsString.h"
+#include "../../libs/EmeraldsVector/export/EmeraldsVector.h"
+#include "../../src/EmeraldsTable.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define MAPPED_TABLE_SPEC_PATH "mapped_table.spec.tmp"
+
+/* Saves a table of 1000 keys and returns the header it was written with */
+static EmeraldsMappedHeader mapped_table_spec_save(void) {
+  EmeraldsTable table = {0};
+  EmeraldsMappedHeader header = {0};
+  char key[16];
+  FILE *file;
+
+  table_init(&table);
+  for(size_t i = 0; i < 1000; i++) {
+    sprintf(key, "key%zu", i);
+    table_add(&table, key, i);
+  }
+  table_save(&table, MAPPED_TABLE_SPEC_PATH);
+  table_deinit(&table);
+
+  file = fopen(MAPPED_TABLE_SPEC_PATH, "rb");
+  fread(&header, sizeof(header), 1, file);
+  fclose(file);
+  return header;
+}
+
+/* Saves the table, overwrites one word of the file and maps it */
+static bool mapped_table_spec_map_patched(uint64_t offset, uint64_t word) {
+  EmeraldsMappedTable mapped;
+  bool accepted;
+  FILE *file;
+
+  mapped_table_spec_save();
+  file = fopen(MAPPED_TABLE_SPEC_PATH, "r+b");
+  fseek(file, (long)offset, SEEK_SET);
+  fwrite(&word, sizeof(word), 1, file);
+  fclose(file);
+
+  accepted = table_map(&mapped, MAPPED_TABLE_SPEC_PATH);
+  mapped_table_unmap(&mapped);
+  remove(MAPPED_TABLE_SPEC_PATH);
+  return accepted;
+}
+
+module(T_mapped_table, {
+  it("refuses missing and foreign files", {
+    EmeraldsMappedTable mapped;
+    assert_that(!table_map(&mapped, "examples/no_such_file.table"));
+    assert_that(!table_map(&mapped, "examples/random_words.txt"));
+    assert_that(mapped.mapping is NULL);
+  });
+
+  it("refuses files hashed by another function", {
+    assert_that(mapped_table_spec_map_patched(0, *(uint64_t *)"EMTABLE"));
+    assert_that(!mapped_table_spec_map_patched(
+      offsetof(EmeraldsMappedHeader, hash_check), 0x5eed
+    ));
+  });
+
+  it("refuses sections whose size wraps around or leaves the file", {
+    assert_that(!mapped_table_spec_map_patched(
+      offsetof(EmeraldsMappedHeader, size), (uint64_t)1 << 59
+    ));
+    assert_that(!mapped_table_spec_map_patched(
+      offsetof(EmeraldsMappedHeader, bucket_count), ~(uint64_t)0 / 2
+    ));
+    assert_that(!mapped_table_spec_map_patched(
+      offsetof(EmeraldsMappedHeader, slots_offset),
+      sizeof(EmeraldsMappedHeader) + 4
+    ));
+  });
+
+  it("refuses slots and remap entries pointing out of range", {
+    EmeraldsMappedHeader header = mapped_table_spec_save();
+    remove(MAPPED_TABLE_SPEC_PATH);
+
+    assert_that(!mapped_table_spec_map_patched(
+      header.slots_offset + offsetof(EmeraldsMappedSlot, key),
+      header.file_size - header.keys_offset + 1
+    ));
+    assert_that(!mapped_table_spec_map_patched(
+      header.slots_offset + offsetof(EmeraldsMappedSlot, length),
+      ~(uint64_t)0
+    ));
+    assert_that(!mapped_table_spec_map_patched(
+      header.remap_offset, header.size
+    ));
+  });
+
+  it("saves and maps an empty table", {
+    EmeraldsTable table = {0};
+    EmeraldsMappedTable mapped;
+    table_init(&table);
+
+    assert_that(table_save(&table, MAPPED_TABLE_SPEC_PATH));
+    assert_that(table_map(&mapped, MAPPED_TABLE_SPEC_PATH));
+    assert_that_size_t(mapped_table_size(&mapped) equals to 0);
+    assert_that_size_t(
+      mapped_table_get(&mapped, "key") equals to TABLE_UNDEFINED
+    );
+
+    mapped_table_unmap(&mapped);
+    table_deinit(&table);
+    remove(MAPPED_TABLE_SPEC_PATH);
+  });
+
+  it("answers lookups from a mapped file with 100000 random words", {
+    EmeraldsTable table = {0};
+    EmeraldsMappedTable mapped;
+    table_init(&table);
+
+    char *words = string_new(file_handler_read("examples/random_words.txt"));
+    char **arr  = string_split(words, '\n');
+
+    for(size_t i = 0; i < vector_size(arr); i++) {
+      table_add(&table, arr[i], i + 1);
+    }
+    table_add(&table, "", 42);
+
+    assert_that(table_save(&table, MAPPED_TABLE_SPEC_PATH));
+    assert_that(table_map(&mapped, MAPPED_TABLE_SPEC_PATH));
+    assert_that_size_t(
+      mapped_table_size(&mapped) equals to table_size(&table)
+    );
+
+    size_t misses = 0;
+    for(size_t i = 0; i < vector_size(arr); i++) {
+      if(mapped_table_get(&mapped, arr[i]) != table_get(&table, arr[i])) {
+        misses++;
+      }
+    }
+    assert_that_size_t(misses equals to 0);
+    assert_that_size_t(mapped_table_get(&mapped, "") equals to 42);
+    assert_that_size_t(mapped_table_get(&mapped, "bfs6Zsw") equals to 1);
+    assert_that_size_t(
+      mapped_table_get_n(&mapped, "tP7hbqI-", 7) equals to 100000
+    );
+    assert_that_size_t(
+      mapped_table_get(&mapped, "not a random word") equals to TABLE_UNDEFINED
+    );
+
+    mapped_table_unmap(&mapped);
+    assert_that(mapped.mapping is NULL);
+    table_deinit(&table);
+    remove(MAPPED_TABLE_SPEC_PATH);
+  });
+})
@@ -0,0 +1,137 @@
+#ifndef __RCU_TABLE_BENCHMARK_SPEC_H_
+#define __RCU_TABLE_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "../../table/benchmarks/table_general_benchmark.spec.h"
+
+#include <pthread.h>
+
+#if defined(__ATOMIC_SEQ_CST)
+
+  #define RCU_BENCHMARK_KEYS        (1000000)
+  #define RCU_BENCHMARK_LOOKUPS     (4000000)
+  #define RCU_BENCHMARK_MAX_THREADS (8)
+
+static char rcu_benchmark_keys[RCU_BENCHMARK_KEYS][16];
+static EmeraldsRcuTable rcu_benchmark_rcu;
+static EmeraldsTable rcu_benchmark_locked;
+static pthread_mutex_t rcu_benchmark_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t rcu_benchmark_stop;
+
+static void *rcu_benchmark_rcu_reader(void *arg) {
+  size_t found  = 0;
+  size_t reader = rcu_table_register(&rcu_benchmark_rcu);
+  size_t i      = (size_t)arg;
+
+  for(size_t n = 0; n < RCU_BENCHMARK_LOOKUPS; n++) {
+    rcu_table_enter(&rcu_benchmark_rcu, reader);
+    found += rcu_table_get(&rcu_benchmark_rcu, rcu_benchmark_keys[i]) !=
+             TABLE_UNDEFINED;
+    rcu_table_leave(&rcu_benchmark_rcu, reader);
+    i = (i + 7919) % RCU_BENCHMARK_KEYS;
+  }
+  rcu_table_unregister(&rcu_benchmark_rcu, reader);
+  return (void *)found;
+}
+
+static void *rcu_benchmark_locked_reader(void *arg) {
+  size_t found = 0;
+  size_t i     = (size_t)arg;
+
+  for(size_t n = 0; n < RCU_BENCHMARK_LOOKUPS; n++) {
+    pthread_mutex_lock(&rcu_benchmark_mutex);
+    found += table_get(&rcu_benchmark_locked, rcu_benchmark_keys[i]) !=
+             TABLE_UNDEFINED;
+    pthread_mutex_unlock(&rcu_benchmark_mutex);
+    i = (i + 7919) % RCU_BENCHMARK_KEYS;
+  }
+  return (void *)found;
+}
+
+/* The writer keeps updating values so readers always race with writes */
+static void *rcu_benchmark_rcu_writer(void *arg) {
+  size_t i = 0;
+  (void)arg;
+  while(!__atomic_load_n(&rcu_benchmark_stop, __ATOMIC_ACQUIRE)) {
+    rcu_table_add(&rcu_benchmark_rcu, rcu_benchmark_keys[i], i);
+    i = (i + 1) % RCU_BENCHMARK_KEYS;
+  }
+  return NULL;
+}
+
+static void *rcu_benchmark_locked_writer(void *arg) {
+  size_t i = 0;
+  (void)arg;
+  while(!__atomic_load_n(&rcu_benchmark_stop, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_lock(&rcu_benchmark_mutex);
+    table_add(&rcu_benchmark_locked, rcu_benchmark_keys[i], i);
+    pthread_mutex_unlock(&rcu_benchmark_mutex);
+    i = (i + 1) % RCU_BENCHMARK_KEYS;
+  }
+  return NULL;
+}
+
+static double rcu_benchmark_run(
+  void *(*reader)(void *), void *(*writer)(void *), size_t threads
+) {
+  pthread_t readers[RCU_BENCHMARK_MAX_THREADS];
+  pthread_t writer_thread;
+  size_t found = 0;
+
+  rcu_benchmark_stop = 0;
+  pthread_create(&writer_thread, NULL, writer, NULL);
+  double start_time = get_time();
+  for(size_t t = 0; t < threads; t++) {
+    pthread_create(&readers[t], NULL, reader, (void *)(t * 104729));
+  }
+  for(size_t t = 0; t < threads; t++) {
+    void *result;
+    pthread_join(readers[t], &result);
+    found += (size_t)result;
+  }
+  double end_time = get_time();
+  __atomic_store_n(&rcu_benchmark_stop, 1, __ATOMIC_RELEASE);
+  pthread_join(writer_thread, NULL);
+
+  assert_that_size_t(found equals to threads * RCU_BENCHMARK_LOOKUPS);
+  return threads * RCU_BENCHMARK_LOOKUPS / (end_time - start_time) / 1e6;
+}
+
+module(T_rcu_table_benchmark, {
+  it("benchmarks lock-free readers against a mutex guarded table", {
+    rcu_table_init(&rcu_benchmark_rcu);
+    table_init(&rcu_benchmark_locked);
+    for(size_t i = 0; i < RCU_BENCHMARK_KEYS; i++) {
+      snprintf(rcu_benchmark_keys[i], 16, "symbol_%zu", i);
+      rcu_table_add(&rcu_benchmark_rcu, rcu_benchmark_keys[i], i);
+      table_add(&rcu_benchmark_locked, rcu_benchmark_keys[i], i);
+    }
+
+    printf("RUNNING RCU TABLE BENCHMARKS\n");
+    for(size_t threads = 1; threads <= RCU_BENCHMARK_MAX_THREADS;
+        threads *= 2) {
+      double rcu = rcu_benchmark_run(
+        rcu_benchmark_rcu_reader, rcu_benchmark_rcu_writer, threads
+      );
+      double locked = rcu_benchmark_run(
+        rcu_benchmark_locked_reader, rcu_benchmark_locked_writer, threads
+      );
+      printf(
+        "%zu readers + 1 writer: rcu %.1f Mlookups/s, mutex %.1f Mlookups/s\n",
+        threads,
+        rcu,
+        locked
+      );
+    }
+
+    rcu_table_deinit(&rcu_benchmark_rcu);
+    table_deinit(&rcu_benchmark_locked);
+  });
+})
+
+#else
+module(T_rcu_table_benchmark, {});
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+#include <pthread.h>
+
+#if defined(__ATOMIC_SEQ_CST)
+
+  #define RCU_TABLE_SPEC_KEYS    (200000)
+  #define RCU_TABLE_SPEC_READERS (4)
+
+static char rcu_table_spec_keys[RCU_TABLE_SPEC_KEYS][16];
+static EmeraldsRcuTable rcu_table_spec_table;
+static size_t rcu_table_spec_done;
+
+/* Every key the writer already published must be visible to readers */
+static void *rcu_table_spec_reader(void *arg) {
+  size_t *errors = (size_t *)arg;
+  size_t reader  = rcu_table_register(&rcu_table_spec_table);
+  size_t i       = 0;
+
+  while(!__atomic_load_n(&rcu_table_spec_done, __ATOMIC_ACQUIRE)) {
+    rcu_table_enter(&rcu_table_spec_table, reader);
+    size_t value = rcu_table_get(&rcu_table_spec_table, rcu_table_spec_keys[i]);
+    if(value != TABLE_UNDEFINED && value != i) {
+      (*errors)++;
+    }
+    if(rcu_table_get(&rcu_table_spec_table, "absent") != TABLE_UNDEFINED) {
+      (*errors)++;
+    }
+    rcu_table_leave(&rcu_table_spec_table, reader);
+    i = (i + 7919) % RCU_TABLE_SPEC_KEYS;
+  }
+  rcu_table_unregister(&rcu_table_spec_table, reader);
+  return NULL;
+}
+
+module(T_rcu_table, {
+  it("inserts, updates and removes from the writer thread", {
+    EmeraldsRcuTable table;
+    rcu_table_init(&table);
+
+    rcu_table_add(&table, "key1", 1);
+    rcu_table_add(&table, "key2", 2);
+    rcu_table_add(&table, "key1", 10);
+    assert_that_size_t(rcu_table_size(&table) equals to 2);
+    assert_that_size_t(rcu_table_get(&table, "key1") equals to 10);
+
+    rcu_table_remove(&table, "key1");
+    assert_that_size_t(rcu_table_get(&table, "key1") equals to TABLE_UNDEFINED);
+    rcu_table_add(&table, "key1", 11);
+    assert_that_size_t(rcu_table_get(&table, "key1") equals to 11);
+    assert_that_size_t(rcu_table_get(&table, "key2") equals to 2);
+    assert_that_size_t(table.tombstones equals to 0);
+
+    rcu_table_deinit(&table);
+  });
+
+  it("hands the slots of unregistered readers out again", {
+    EmeraldsRcuTable table;
+    size_t readers[RCU_TABLE_MAX_READERS];
+    rcu_table_init(&table);
+
+    for(size_t i = 0; i < RCU_TABLE_MAX_READERS; i++) {
+      readers[i] = rcu_table_register(&table);
+    }
+    assert_that_size_t(rcu_table_register(&table) equals to TABLE_UNDEFINED);
+
+    rcu_table_unregister(&table, readers[5]);
+    assert_that_size_t(rcu_table_register(&table) equals to readers[5]);
+
+    /* A pool recycling its threads registers far more often than 64 times */
+    rcu_table_unregister(&table, readers[0]);
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 1000; i++) {
+      size_t reader = rcu_table_register(&table);
+      if(reader != readers[0]) {
+        mismatches++;
+        continue;
+      }
+      rcu_table_enter(&table, reader);
+      rcu_table_leave(&table, reader);
+      rcu_table_unregister(&table, reader);
+    }
+    assert_that_size_t(mismatches equals to 0);
+
+    rcu_table_deinit(&table);
+  });
+
+  it("frees retired generations only after their readers leave", {
+    EmeraldsRcuTable table;
+    char keys[2000][16];
+    rcu_table_init(&table);
+    size_t reader = rcu_table_register(&table);
+
+    rcu_table_enter(&table, reader);
+    for(size_t i = 0; i < 2000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "key_%zu", i);
+      rcu_table_add(&table, keys[i], i);
+    }
+    assert_that(rcu_table_reclaim(&table) isnot 0);
+    rcu_table_leave(&table, reader);
+    assert_that_size_t(rcu_table_reclaim(&table) equals to 0);
+    assert_that_size_t(rcu_table_get(&table, "key_1999") equals to 1999);
+
+    rcu_table_unregister(&table, reader);
+    rcu_table_deinit(&table);
+  });
+
+  it("serves concurrent readers while the writer grows the table", {
+    pthread_t readers[RCU_TABLE_SPEC_READERS];
+    size_t errors[RCU_TABLE_SPEC_READERS] = {0};
+
+    rcu_table_init(&rcu_table_spec_table);
+    rcu_table_spec_done = 0;
+    for(size_t i = 0; i < RCU_TABLE_SPEC_KEYS; i++) {
+      snprintf(rcu_table_spec_keys[i], 16, "rcu_%zu", i);
+    }
+    for(size_t t = 0; t < RCU_TABLE_SPEC_READERS; t++) {
+      pthread_create(&readers[t], NULL, rcu_table_spec_reader, &errors[t]);
+    }
+
+    for(size_t i = 0; i < RCU_TABLE_SPEC_KEYS; i++) {
+      rcu_table_add(&rcu_table_spec_table, rcu_table_spec_keys[i], i);
+      if(i % 3 == 0) {
+        rcu_table_remove(&rcu_table_spec_table, rcu_table_spec_keys[i / 2]);
+        rcu_table_add(&rcu_table_spec_table, rcu_table_spec_keys[i / 2], i / 2);
+      }
+    }
+    __atomic_store_n(&rcu_table_spec_done, 1, __ATOMIC_RELEASE);
+
+    size_t total_errors = 0;
+    for(size_t t = 0; t < RCU_TABLE_SPEC_READERS; t++) {
+      pthread_join(readers[t], NULL);
+      total_errors += errors[t];
+    }
+    assert_that_size_t(total_errors equals to 0);
+    assert_that_size_t(
+      rcu_table_size(&rcu_table_spec_table) equals to RCU_TABLE_SPEC_KEYS
+    );
+
+    rcu_table_deinit(&rcu_table_spec_table);
+  });
+})
+
+#else
+module(T_rcu_table, {});
+#endif
@@ -0,0 +1,109 @@
+#ifndef __SHARDED_TABLE_BENCHMARK_SPEC_H_
+#define __SHARDED_TABLE_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "../../table/benchmarks/table_general_benchmark.spec.h"
+
+#include <pthread.h>
+
+#if defined(SHARDED_TABLE_AVAILABLE)
+
+  #define SHARDED_BENCHMARK_KEYS        (1000000)
+  #define SHARDED_BENCHMARK_MAX_THREADS (8)
+
+static char sharded_benchmark_names[SHARDED_BENCHMARK_KEYS][16];
+static const char *sharded_benchmark_keys[SHARDED_BENCHMARK_KEYS];
+static size_t sharded_benchmark_values[SHARDED_BENCHMARK_KEYS];
+static EmeraldsShardedTable sharded_benchmark_sharded;
+static EmeraldsTable sharded_benchmark_locked;
+static pthread_mutex_t sharded_benchmark_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t sharded_benchmark_threads;
+
+static void *sharded_benchmark_sharded_writer(void *arg) {
+  for(size_t i = (size_t)arg; i < SHARDED_BENCHMARK_KEYS;
+      i += sharded_benchmark_threads) {
+    sharded_table_add(&sharded_benchmark_sharded, sharded_benchmark_keys[i], i);
+  }
+  return NULL;
+}
+
+static void *sharded_benchmark_locked_writer(void *arg) {
+  for(size_t i = (size_t)arg; i < SHARDED_BENCHMARK_KEYS;
+      i += sharded_benchmark_threads) {
+    pthread_mutex_lock(&sharded_benchmark_mutex);
+    table_add(&sharded_benchmark_locked, sharded_benchmark_keys[i], i);
+    pthread_mutex_unlock(&sharded_benchmark_mutex);
+  }
+  return NULL;
+}
+
+static double sharded_benchmark_run(void *(*writer)(void *), size_t threads) {
+  pthread_t writers[SHARDED_BENCHMARK_MAX_THREADS];
+
+  sharded_benchmark_threads = threads;
+  double start_time         = get_time();
+  for(size_t t = 0; t < threads; t++) {
+    pthread_create(&writers[t], NULL, writer, (void *)t);
+  }
+  for(size_t t = 0; t < threads; t++) {
+    pthread_join(writers[t], NULL);
+  }
+  return SHARDED_BENCHMARK_KEYS / (get_time() - start_time) / 1e6;
+}
+
+module(T_sharded_table_benchmark, {
+  it("benchmarks sharded inserts against a mutex guarded table", {
+    for(size_t i = 0; i < SHARDED_BENCHMARK_KEYS; i++) {
+      snprintf(sharded_benchmark_names[i], 16, "ingest_%zu", i);
+      sharded_benchmark_keys[i]   = sharded_benchmark_names[i];
+      sharded_benchmark_values[i] = i;
+    }
+
+    printf("RUNNING SHARDED TABLE BENCHMARKS\n");
+    for(size_t threads = 1; threads <= SHARDED_BENCHMARK_MAX_THREADS;
+        threads *= 2) {
+      sharded_table_init(
+        &sharded_benchmark_sharded, SHARDED_TABLE_DEFAULT_BITS
+      );
+      table_init(&sharded_benchmark_locked);
+      double sharded =
+        sharded_benchmark_run(sharded_benchmark_sharded_writer, threads);
+      double locked =
+        sharded_benchmark_run(sharded_benchmark_locked_writer, threads);
+      sharded_table_deinit(&sharded_benchmark_sharded);
+      table_deinit(&sharded_benchmark_locked);
+
+      double start_time = get_time();
+      sharded_table_build(
+        &sharded_benchmark_sharded,
+        SHARDED_TABLE_DEFAULT_BITS,
+        sharded_benchmark_keys,
+        sharded_benchmark_values,
+        SHARDED_BENCHMARK_KEYS,
+        threads
+      );
+      double build = SHARDED_BENCHMARK_KEYS / (get_time() - start_time) / 1e6;
+      assert_that_size_t(
+        sharded_table_size(&sharded_benchmark_sharded) equals to
+          SHARDED_BENCHMARK_KEYS
+      );
+      sharded_table_deinit(&sharded_benchmark_sharded);
+
+      printf(
+        "%zu threads: sharded %.1f Minserts/s, mutex %.1f Minserts/s, "
+        "build %.1f Minserts/s\n",
+        threads,
+        sharded,
+        locked,
+        build
+      );
+    }
+  });
+})
+
+#else
+module(T_sharded_table_benchmark, {});
+#endif
+
+#endif
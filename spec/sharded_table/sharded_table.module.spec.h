@@ -0,0 +1,161 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+#include <pthread.h>
+
+#if defined(SHARDED_TABLE_AVAILABLE)
+
+  #define SHARDED_TABLE_SPEC_THREADS (4)
+  #define SHARDED_TABLE_SPEC_KEYS    (20000)
+
+static char sharded_table_spec_keys[SHARDED_TABLE_SPEC_THREADS]
+                                   [SHARDED_TABLE_SPEC_KEYS][16];
+static EmeraldsShardedTable sharded_table_spec_table;
+
+static void *sharded_table_spec_writer(void *arg) {
+  size_t thread = (size_t)arg;
+  char(*keys)[16] = sharded_table_spec_keys[thread];
+
+  for(size_t i = 0; i < SHARDED_TABLE_SPEC_KEYS; i++) {
+    sharded_table_add(&sharded_table_spec_table, keys[i], i);
+    if(i % 3 == 0) {
+      sharded_table_remove(&sharded_table_spec_table, keys[i / 2]);
+      sharded_table_add(&sharded_table_spec_table, keys[i / 2], i / 2);
+    }
+  }
+  return NULL;
+}
+
+/* Entries of one shard are visited by one thread, so per shard sums need no
+ * synchronization */
+static void sharded_table_spec_sum(
+  void *context, size_t shard, const char *key, size_t keylen, size_t value
+) {
+  size_t *sums = (size_t *)context;
+  (void)key;
+  (void)keylen;
+  sums[shard] += value;
+}
+
+module(T_sharded_table, {
+  it("inserts, updates and removes across shards", {
+    EmeraldsShardedTable table;
+    sharded_table_init(&table, 3);
+
+    sharded_table_add(&table, "key1", 1);
+    sharded_table_add(&table, "key2", 2);
+    sharded_table_add(&table, "key1", 10);
+    assert_that_size_t(sharded_table_size(&table) equals to 2);
+    assert_that_size_t(sharded_table_get(&table, "key1") equals to 10);
+    assert_that_size_t(sharded_table_get_n(&table, "key2xyz", 4) equals to 2);
+
+    sharded_table_remove(&table, "key1");
+    assert_that_size_t(
+      sharded_table_get(&table, "key1") equals to TABLE_UNDEFINED
+    );
+    assert_that_size_t(sharded_table_size(&table) equals to 1);
+
+    sharded_table_deinit(&table);
+  });
+
+  it("routes keys by hash bits the shards do not use", {
+    EmeraldsShardedTable table;
+    sharded_table_init(&table, 2);
+
+    sharded_table_add(&table, "routed", 7);
+    size_t shard = SHARDED_TABLE_SHARD(komihash_hash("routed", 6), 2);
+    assert_that_size_t(
+      table_get(&table.shards[shard].table, "routed") equals to 7
+    );
+    assert_that_size_t(SHARDED_TABLE_SHARD(12345, 0) equals to 0);
+
+    sharded_table_deinit(&table);
+  });
+
+  it("leaves every 7 bit fingerprint to the keys of a shard", {
+    bool seen[128] = {false};
+    size_t fingerprints = 0;
+    char key[32];
+
+    for(size_t i = 0; i < 100000; i++) {
+      size_t length = (size_t)snprintf(key, sizeof(key), "fingerprint_%zu", i);
+      size_t hash   = TABLE_HASH_FUNCTION(key, length);
+      if(SHARDED_TABLE_SHARD(hash, SHARDED_TABLE_DEFAULT_BITS) == 1) {
+        seen[hash >> (sizeof(size_t) * 8 - 7)] = true;
+      }
+    }
+    for(size_t i = 0; i < 128; i++) {
+      fingerprints += seen[i];
+    }
+    assert_that_size_t(fingerprints equals to 128);
+  });
+
+  it("builds from arrays and visits every entry in parallel", {
+    const size_t n        = 10000;
+    char(*names)[16]      = malloc(n * sizeof(*names));
+    const char **keys     = malloc(n * sizeof(char *));
+    size_t *values        = malloc(n * sizeof(size_t));
+    size_t sums[16]       = {0};
+    size_t total          = 0;
+    EmeraldsShardedTable table;
+
+    for(size_t i = 0; i < n; i++) {
+      snprintf(names[i], 16, "build_%zu", i);
+      keys[i]   = names[i];
+      values[i] = i;
+    }
+    sharded_table_build(&table, 4, keys, values, n, 4);
+    assert_that_size_t(sharded_table_size(&table) equals to n);
+    for(size_t i = 0; i < n; i++) {
+      total += sharded_table_get(&table, keys[i]) == i;
+    }
+    assert_that_size_t(total equals to n);
+
+    sharded_table_for_each(&table, sharded_table_spec_sum, sums, 4);
+    total = 0;
+    for(size_t s = 0; s < 16; s++) {
+      total += sums[s];
+    }
+    assert_that_size_t(total equals to n * (n - 1) / 2);
+
+    sharded_table_deinit(&table);
+    free(names);
+    free(keys);
+    free(values);
+  });
+
+  it("keeps every key while several writers grow different shards", {
+    pthread_t writers[SHARDED_TABLE_SPEC_THREADS];
+
+    sharded_table_init(&sharded_table_spec_table, SHARDED_TABLE_DEFAULT_BITS);
+    for(size_t t = 0; t < SHARDED_TABLE_SPEC_THREADS; t++) {
+      for(size_t i = 0; i < SHARDED_TABLE_SPEC_KEYS; i++) {
+        snprintf(sharded_table_spec_keys[t][i], 16, "s%zu_%zu", t, i);
+      }
+      pthread_create(&writers[t], NULL, sharded_table_spec_writer, (void *)t);
+    }
+    for(size_t t = 0; t < SHARDED_TABLE_SPEC_THREADS; t++) {
+      pthread_join(writers[t], NULL);
+    }
+
+    size_t errors = 0;
+    for(size_t t = 0; t < SHARDED_TABLE_SPEC_THREADS; t++) {
+      for(size_t i = 0; i < SHARDED_TABLE_SPEC_KEYS; i++) {
+        errors += sharded_table_get(
+                    &sharded_table_spec_table, sharded_table_spec_keys[t][i]
+                  ) != i;
+      }
+    }
+    assert_that_size_t(errors equals to 0);
+    assert_that_size_t(
+      sharded_table_size(&sharded_table_spec_table) equals to
+        SHARDED_TABLE_SPEC_THREADS * SHARDED_TABLE_SPEC_KEYS
+    );
+
+    sharded_table_deinit(&sharded_table_spec_table);
+  });
+})
+
+#else
+module(T_sharded_table, {});
+#endif
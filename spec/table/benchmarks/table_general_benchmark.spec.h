@@ -4,6 +4,7 @@
 #include "../../../libs/cSpec/export/cSpec.h"
 #include "../../../src/EmeraldsTable.h"
 
+/* Monotonic seconds, every benchmark times itself with this clock */
 #if defined(_WIN32)
   #include <windows.h>
 static double get_time() {
@@ -13,11 +14,11 @@ static double get_time() {
   return (double)count.QuadPart / freq.QuadPart;
 }
 #else
-  #include <sys/time.h>
+  #include <time.h>
 static double get_time() {
-  struct timeval t;
-  gettimeofday(&t, NULL);
-  return t.tv_sec + t.tv_usec * 1e-6;
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
 }
 #endif
 
@@ -35,8 +36,44 @@ static char *generate_random_string(size_t length) {
   return random_string;
 }
 
+/* Resident set size in kB, the current one or the peak since the last reset */
+static size_t benchmark_rss_kb(const char *field) {
+  size_t kb = 0;
+#if defined(__linux__)
+  char line[256];
+  FILE *file = fopen("/proc/self/status", "r");
+  if(file == NULL) {
+    return 0;
+  }
+  while(fgets(line, sizeof(line), file)) {
+    if(strncmp(line, field, strlen(field)) == 0) {
+      sscanf(line + strlen(field), "%zu", &kb);
+      break;
+    }
+  }
+  fclose(file);
+#else
+  (void)field;
+#endif
+  return kb;
+}
+
+/* Starts a new peak RSS measurement at the current RSS (Linux 4.0) */
+static void benchmark_reset_peak_rss() {
+#if defined(__linux__)
+  FILE *file = fopen("/proc/self/clear_refs", "w");
+  if(file != NULL) {
+    fputs("5", file);
+    fclose(file);
+  }
+#endif
+}
+
 static void
 benchmark_insertion(EmeraldsTable *table, char **keys, size_t count) {
+  size_t rss_before;
+  benchmark_reset_peak_rss();
+  rss_before        = benchmark_rss_kb("VmRSS:");
   double start_time = get_time();
   for(size_t i = 0; i < count; i++) {
     table_add(table, keys[i], i);
@@ -45,6 +82,27 @@ benchmark_insertion(EmeraldsTable *table, char **keys, size_t count) {
   printf(
     "Insertion of %zu items took %f seconds.\n", count, end_time - start_time
   );
+  printf(
+    "The table holds %zu MB, its growth peaked at %zu MB.\n",
+    (benchmark_rss_kb("VmRSS:") - rss_before) / 1024,
+    (benchmark_rss_kb("VmHWM:") - rss_before) / 1024
+  );
+}
+
+static void benchmark_bulk_build(char **keys, size_t count) {
+  EmeraldsTable table = {0};
+  size_t *values      = malloc(sizeof(size_t) * count);
+  for(size_t i = 0; i < count; i++) {
+    values[i] = i;
+  }
+  double start_time = get_time();
+  table_build_from_arrays(&table, (const char **)keys, values, count);
+  double end_time = get_time();
+  printf(
+    "Bulk build of %zu items took %f seconds.\n", count, end_time - start_time
+  );
+  table_deinit(&table);
+  free(values);
 }
 
 static void benchmark_lookup(EmeraldsTable *table, char **keys, size_t count) {
@@ -65,6 +123,29 @@ static void benchmark_lookup(EmeraldsTable *table, char **keys, size_t count) {
   );
 }
 
+static void
+benchmark_batch_lookup(EmeraldsTable *table, char **keys, size_t count) {
+  size_t values[1024];
+  double start_time = get_time();
+  size_t not_found  = 0;
+  for(size_t i = 0; i < count; i += 1024) {
+    size_t n = count - i < 1024 ? count - i : 1024;
+    table_get_batch(table, (const char **)keys + i, n, values);
+    for(size_t j = 0; j < n; j++) {
+      if(values[j] == TABLE_UNDEFINED) {
+        not_found++;
+      }
+    }
+  }
+  double end_time = get_time();
+  printf(
+    "Batched lookup of %zu items took %f seconds (%zu not found).\n",
+    count,
+    end_time - start_time,
+    not_found
+  );
+}
+
 static void
 benchmark_deletion(EmeraldsTable *table, char **keys, size_t count) {
   double start_time = get_time();
@@ -129,11 +210,14 @@ module(T_table_general_benchmark, {
     printf("RUNNING BENCHMARKS\n");
 
     benchmark_insertion(&table, keys, ITEM_COUNT);
+    benchmark_bulk_build(keys, ITEM_COUNT);
     benchmark_lookup(&table, keys, ITEM_COUNT);
+    benchmark_batch_lookup(&table, keys, ITEM_COUNT);
     benchmark_insert_duplicates(&table, keys, ITEM_COUNT);
     benchmark_lookup(&table, keys, ITEM_COUNT);
     benchmark_deletion(&table, keys, ITEM_COUNT);
     benchmark_lookup(&table, keys, ITEM_COUNT);
+    benchmark_batch_lookup(&table, keys, ITEM_COUNT);
     benchmark_remove_nonexistent(&table, ITEM_COUNT);
   });
 })
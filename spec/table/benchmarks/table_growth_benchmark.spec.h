@@ -0,0 +1,49 @@
+#ifndef __TABLE_GROWTH_BENCHMARK_SPEC_H_
+#define __TABLE_GROWTH_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "table_general_benchmark.spec.h"
+
+#define GROWTH_BENCHMARK_MIN_CAPACITY (1 << 14)
+#define GROWTH_BENCHMARK_MAX_CAPACITY (1 << 23)
+
+module(T_table_growth_benchmark, {
+  it("benchmarks a single doubling across table sizes", {
+    size_t n = (size_t)(GROWTH_BENCHMARK_MAX_CAPACITY * TABLE_LOAD_FACTOR) + 2;
+    char(*keys)[16] = malloc(n * sizeof(*keys));
+    for(size_t i = 0; i < n; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "growth_%zu", i);
+    }
+
+    printf("RUNNING GROWTH BENCHMARKS\n");
+    for(size_t capacity = GROWTH_BENCHMARK_MIN_CAPACITY;
+        capacity <= GROWTH_BENCHMARK_MAX_CAPACITY;
+        capacity *= 4) {
+      /* One key past the load factor, the next insert doubles the table */
+      size_t count = (size_t)(capacity * TABLE_LOAD_FACTOR) + 1;
+      EmeraldsTable table;
+      table_init(&table);
+      for(size_t i = 0; i < count; i++) {
+        table_add(&table, keys[i], i);
+      }
+      assert_that_size_t(table.capacity equals to capacity);
+
+      double start_time = get_time();
+      table_add(&table, keys[count], count);
+      double elapsed = get_time() - start_time;
+      assert_that_size_t(table.capacity equals to capacity * TABLE_GROW_FACTOR);
+
+      printf(
+        "%zu buckets: grown in %.2fms, %.1fns per entry\n",
+        capacity,
+        elapsed * 1e3,
+        elapsed * 1e9 / count
+      );
+      table_deinit(&table);
+    }
+    free(keys);
+  });
+})
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef __TABLE_LATENCY_BENCHMARK_SPEC_H_
+#define __TABLE_LATENCY_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "table_general_benchmark.spec.h"
+
+#define LATENCY_ITEM_COUNT 10000000
+#define LATENCY_ITEM_SIZE  10
+
+#if defined(TABLE_INCREMENTAL_REHASH)
+  #define LATENCY_REHASH_MODE "incremental rehash"
+#else
+  #define LATENCY_REHASH_MODE "stop-the-world rehash"
+#endif
+
+static int latency_compare(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void latency_report(const char *name, double *samples, size_t count) {
+  qsort(samples, count, sizeof(double), latency_compare);
+  printf(
+    "%s (%s): p50 %.0fns, p99 %.0fns, p999 %.0fns, max %.0fns\n",
+    name,
+    LATENCY_REHASH_MODE,
+    samples[count / 2],
+    samples[(size_t)(count * 0.99)],
+    samples[(size_t)(count * 0.999)],
+    samples[count - 1]
+  );
+}
+
+module(T_table_latency_benchmark, {
+  it("benchmarks the tail latency of table_add and table_get", {
+    static const char charset[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char **keys     = malloc(sizeof(char *) * LATENCY_ITEM_COUNT);
+    double *samples = malloc(sizeof(double) * LATENCY_ITEM_COUNT);
+    for(size_t i = 0; i < LATENCY_ITEM_COUNT; i++) {
+      keys[i] = malloc(LATENCY_ITEM_SIZE + 1);
+      for(size_t n = 0; n < LATENCY_ITEM_SIZE; n++) {
+        keys[i][n] = charset[rand() % (int)(sizeof(charset) - 1)];
+      }
+      keys[i][LATENCY_ITEM_SIZE] = '\0';
+    }
+
+    printf("RUNNING LATENCY BENCHMARKS\n");
+
+    for(size_t i = 0; i < LATENCY_ITEM_COUNT; i++) {
+      double start = get_time();
+      table_add(&table, keys[i], i);
+      samples[i] = (get_time() - start) * 1e9;
+    }
+    latency_report("Insertion", samples, LATENCY_ITEM_COUNT);
+
+    for(size_t i = 0; i < LATENCY_ITEM_COUNT; i++) {
+      double start = get_time();
+      (void)table_get(&table, keys[i]);
+      samples[i] = (get_time() - start) * 1e9;
+    }
+    latency_report("Lookup", samples, LATENCY_ITEM_COUNT);
+
+    table_deinit(&table);
+    for(size_t i = 0; i < LATENCY_ITEM_COUNT; i++) {
+      free(keys[i]);
+    }
+    free(keys);
+    free(samples);
+  });
+})
+
+#endif
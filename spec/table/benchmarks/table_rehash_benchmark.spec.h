@@ -0,0 +1,61 @@
+#ifndef __TABLE_REHASH_BENCHMARK_SPEC_H_
+#define __TABLE_REHASH_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "table_general_benchmark.spec.h"
+
+#if defined(TABLE_PARALLEL_REHASH)
+
+  #define REHASH_BENCHMARK_CAPACITY    (1 << 22)
+  #define REHASH_BENCHMARK_MAX_THREADS (32)
+
+module(T_table_rehash_benchmark, {
+  it("benchmarks growing a large table with 1 to 32 threads", {
+    /* One key past the load factor, the next insert doubles the table */
+    size_t n = (size_t)(REHASH_BENCHMARK_CAPACITY * TABLE_LOAD_FACTOR) + 2;
+    char(*keys)[16] = malloc(n * sizeof(*keys));
+    double serial   = 0;
+    for(size_t i = 0; i < n; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "rehash_%zu", i);
+    }
+
+    printf("RUNNING REHASH BENCHMARKS\n");
+    for(size_t threads = 1; threads <= REHASH_BENCHMARK_MAX_THREADS;
+        threads *= 2) {
+      EmeraldsTable table;
+      table_init(&table);
+      table.rehash_threads = threads;
+      for(size_t i = 0; i + 1 < n; i++) {
+        table_add(&table, keys[i], i);
+      }
+      assert_that_size_t(table.capacity equals to REHASH_BENCHMARK_CAPACITY);
+
+      double start_time = get_time();
+      table_add(&table, keys[n - 1], n - 1);
+      double elapsed = get_time() - start_time;
+      assert_that_size_t(
+        table.capacity equals to REHASH_BENCHMARK_CAPACITY * TABLE_GROW_FACTOR
+      );
+
+      if(threads == 1) {
+        serial = elapsed;
+      }
+      printf(
+        "%zu threads: %zu buckets rehashed in %.1fms (%.2fx)\n",
+        threads,
+        (size_t)REHASH_BENCHMARK_CAPACITY,
+        elapsed * 1e3,
+        serial / elapsed
+      );
+      table_deinit(&table);
+    }
+    free(keys);
+  });
+})
+
+#else
+module(T_table_rehash_benchmark, {});
+#endif
+
+#endif
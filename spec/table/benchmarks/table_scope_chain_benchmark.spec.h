@@ -0,0 +1,72 @@
+#ifndef __TABLE_SCOPE_CHAIN_BENCHMARK_SPEC_H_
+#define __TABLE_SCOPE_CHAIN_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "table_general_benchmark.spec.h"
+
+#define SCOPE_CHAIN_DEPTH   5
+#define SCOPE_CHAIN_NAMES   1000
+#define SCOPE_CHAIN_LOOKUPS 10000000
+
+module(T_table_scope_chain_benchmark, {
+  it("benchmarks resolving names through a 5-deep scope chain", {
+    EmeraldsTable scopes[SCOPE_CHAIN_DEPTH];
+    char names[SCOPE_CHAIN_NAMES][24];
+    EmeraldsTableKey handles[SCOPE_CHAIN_NAMES];
+    size_t found = 0;
+
+    /* Innermost scope is the last one, every name lives in a single scope */
+    for(size_t d = 0; d < SCOPE_CHAIN_DEPTH; d++) {
+      table_init(&scopes[d]);
+    }
+    for(size_t i = 0; i < SCOPE_CHAIN_NAMES; i++) {
+      snprintf(names[i], sizeof(names[i]), "identifier_%zu", i);
+      table_add(&scopes[i % SCOPE_CHAIN_DEPTH], names[i], i);
+      handles[i] = table_key(names[i]);
+    }
+
+    printf("RUNNING SCOPE CHAIN BENCHMARKS\n");
+
+    double start_time = get_time();
+    for(size_t i = 0; i < SCOPE_CHAIN_LOOKUPS; i++) {
+      const char *name = names[i % SCOPE_CHAIN_NAMES];
+      for(size_t d = SCOPE_CHAIN_DEPTH; d-- > 0;) {
+        if(table_get(&scopes[d], name) != TABLE_UNDEFINED) {
+          found++;
+          break;
+        }
+      }
+    }
+    double end_time = get_time();
+    printf(
+      "Scope chain lookup with table_get of %d names took %f seconds.\n",
+      SCOPE_CHAIN_LOOKUPS,
+      end_time - start_time
+    );
+
+    start_time = get_time();
+    for(size_t i = 0; i < SCOPE_CHAIN_LOOKUPS; i++) {
+      const EmeraldsTableKey *handle = &handles[i % SCOPE_CHAIN_NAMES];
+      for(size_t d = SCOPE_CHAIN_DEPTH; d-- > 0;) {
+        if(table_get_h(&scopes[d], handle) != TABLE_UNDEFINED) {
+          found++;
+          break;
+        }
+      }
+    }
+    end_time = get_time();
+    printf(
+      "Scope chain lookup with table_get_h of %d names took %f seconds.\n",
+      SCOPE_CHAIN_LOOKUPS,
+      end_time - start_time
+    );
+
+    assert_that_size_t(found equals to 2 * SCOPE_CHAIN_LOOKUPS);
+    for(size_t d = 0; d < SCOPE_CHAIN_DEPTH; d++) {
+      table_deinit(&scopes[d]);
+    }
+  });
+})
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef __TABLE_SMALL_BENCHMARK_SPEC_H_
+#define __TABLE_SMALL_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "table_general_benchmark.spec.h"
+
+#define SMALL_BENCHMARK_TABLES  10000
+#define SMALL_BENCHMARK_ENTRIES 6
+#define SMALL_BENCHMARK_ROUNDS  1000
+
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+  #define SMALL_BENCHMARK_BUCKET_BYTES (sizeof(EmeraldsTableSlot) + 1)
+#else
+  #define SMALL_BENCHMARK_BUCKET_BYTES (4 * sizeof(size_t) + 1)
+#endif
+
+module(T_table_small_benchmark, {
+  it("benchmarks creating many empty and small tables", {
+    EmeraldsTable *tables =
+      malloc(SMALL_BENCHMARK_TABLES * sizeof(EmeraldsTable));
+    char names[SMALL_BENCHMARK_ENTRIES][16];
+    EmeraldsTableKey handles[SMALL_BENCHMARK_ENTRIES];
+    size_t found   = 0;
+    size_t buckets = 0;
+
+    for(size_t i = 0; i < SMALL_BENCHMARK_ENTRIES; i++) {
+      snprintf(names[i], sizeof(names[i]), "field_%zu", i);
+      handles[i] = table_key(names[i]);
+    }
+
+    printf("RUNNING SMALL TABLE BENCHMARKS\n");
+
+    double start_time = get_time();
+    for(size_t round = 0; round < SMALL_BENCHMARK_ROUNDS; round++) {
+      for(size_t t = 0; t < SMALL_BENCHMARK_TABLES; t++) {
+        table_init(&tables[t]);
+      }
+      for(size_t t = 0; t < SMALL_BENCHMARK_TABLES; t++) {
+        table_deinit(&tables[t]);
+      }
+    }
+    double end_time = get_time();
+    printf(
+      "Creating and freeing an empty table took %f ns.\n",
+      (end_time - start_time) * 1e9 /
+        (SMALL_BENCHMARK_TABLES * SMALL_BENCHMARK_ROUNDS)
+    );
+
+    start_time = get_time();
+    for(size_t t = 0; t < SMALL_BENCHMARK_TABLES; t++) {
+      table_init(&tables[t]);
+      for(size_t i = 0; i < SMALL_BENCHMARK_ENTRIES; i++) {
+        table_add(&tables[t], names[i], i);
+      }
+      buckets += tables[t].capacity;
+    }
+    end_time = get_time();
+    printf(
+      "Filling a table with %d entries took %f ns, %zu bucket bytes each.\n",
+      SMALL_BENCHMARK_ENTRIES,
+      (end_time - start_time) * 1e9 / SMALL_BENCHMARK_TABLES,
+      buckets / SMALL_BENCHMARK_TABLES * SMALL_BENCHMARK_BUCKET_BYTES
+    );
+
+    start_time = get_time();
+    for(size_t round = 0; round < SMALL_BENCHMARK_ROUNDS; round++) {
+      for(size_t t = 0; t < SMALL_BENCHMARK_TABLES; t++) {
+        const EmeraldsTableKey *handle =
+          &handles[(t + round) % SMALL_BENCHMARK_ENTRIES];
+        found += table_get_h(&tables[t], handle) != TABLE_UNDEFINED;
+      }
+    }
+    end_time = get_time();
+    printf(
+      "Looking a key handle up in a small table took %f ns.\n",
+      (end_time - start_time) * 1e9 /
+        (SMALL_BENCHMARK_TABLES * SMALL_BENCHMARK_ROUNDS)
+    );
+
+    assert_that_size_t(
+      found equals to SMALL_BENCHMARK_TABLES * SMALL_BENCHMARK_ROUNDS
+    );
+    for(size_t t = 0; t < SMALL_BENCHMARK_TABLES; t++) {
+      table_deinit(&tables[t]);
+    }
+    free(tables);
+  });
+})
+
+#endif
@@ -4,6 +4,26 @@
 #include "../../libs/EmeraldsVector/export/EmeraldsVector.h"
 #include "../../src/EmeraldsTable.h"
 
+/* Tracks the bytes a table holds through its allocator */
+static size_t table_spec_outstanding;
+
+static void *table_spec_allocate(void *context, size_t bytes) {
+  *(size_t *)context += bytes;
+  return malloc(bytes);
+}
+
+static void *table_spec_reallocate(
+  void *context, void *memory, size_t old_bytes, size_t bytes
+) {
+  *(size_t *)context += bytes - old_bytes;
+  return realloc(memory, bytes);
+}
+
+static void table_spec_release(void *context, void *memory, size_t bytes) {
+  *(size_t *)context -= bytes;
+  free(memory);
+}
+
 module(T_table, {
   it("inserts the empty string into the hash table", {
     EmeraldsTable table = {0};
@@ -18,20 +38,135 @@ module(T_table, {
     table_init(&table);
 
     assert_that_size_t((&table)->size equals to 0);
-    assert_that_size_t(vector_capacity((&table)->hashes) equals to 1024);
-    assert_that_size_t(vector_capacity((&table)->states) equals to 1024);
-    assert_that_size_t(vector_capacity((&table)->keys) equals to 1024);
-    assert_that_size_t(vector_capacity((&table)->values) equals to 1024);
+    assert_that_size_t((&table)->capacity equals to 0);
+    assert_that(table.states is NULL);
+    assert_that_size_t(table_get(&table, "key1") equals to TABLE_UNDEFINED);
 
     table_add(&table, "key1", 100);
     assert_that_size_t((&table)->size equals to 1);
+#if TABLE_SMALL_SIZE > 0
+    assert_that_size_t((&table)->capacity equals to TABLE_SMALL_SIZE);
+#endif
 
     table_deinit(&table);
 
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+    assert_that(table.slots is NULL);
+    assert_that(table.states is NULL);
+#else
     assert_that(table.hashes is NULL);
+    assert_that(table.lengths is NULL);
     assert_that(table.states is NULL);
     assert_that(table.keys is NULL);
     assert_that(table.values is NULL);
+#endif
+  });
+
+#if TABLE_SMALL_SIZE >= 2
+  it("keeps small tables packed and hashes them once they outgrow it", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char keys[TABLE_SMALL_SIZE + 1][16];
+    for(size_t i = 0; i <= TABLE_SMALL_SIZE; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "small_%zu", i);
+    }
+    table_remove(&table, keys[0]);
+    for(size_t i = 0; i < TABLE_SMALL_SIZE; i++) {
+      table_add(&table, keys[i], i);
+    }
+    table_add(&table, keys[0], 42);
+    table_remove(&table, keys[1]);
+    table_add(&table, keys[1], 1);
+    assert_that_size_t(table.capacity equals to TABLE_SMALL_SIZE);
+    assert_that_size_t(table_size(&table) equals to TABLE_SMALL_SIZE);
+
+    size_t packed = 0;
+    while(packed < TABLE_SMALL_SIZE &&
+          TABLE_STATE_IS_FILLED(table.states[packed])) {
+      packed++;
+    }
+    assert_that_size_t(packed equals to TABLE_SMALL_SIZE);
+    assert_that_size_t(table_get(&table, keys[0]) equals to 42);
+    assert_that_size_t(table_get(&table, keys[1]) equals to 1);
+    assert_that_size_t(
+      table_get(&table, keys[TABLE_SMALL_SIZE]) equals to TABLE_UNDEFINED
+    );
+
+    table_add(&table, keys[TABLE_SMALL_SIZE], TABLE_SMALL_SIZE);
+    assert_that_size_t(table.capacity equals to TABLE_INITIAL_SIZE);
+    size_t mismatches = 0;
+    for(size_t i = 2; i <= TABLE_SMALL_SIZE; i++) {
+      mismatches += table_get(&table, keys[i]) != i;
+    }
+    assert_that_size_t(mismatches equals to 0);
+    assert_that_size_t(table_get(&table, keys[0]) equals to 42);
+    assert_that_size_t(table_size(&table) equals to TABLE_SMALL_SIZE + 1);
+
+    table_deinit(&table);
+  });
+#endif
+
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+  it("keeps slots in a single cache line aligned block", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+    assert_that(table.block is NULL);
+
+    char keys[TABLE_SMALL_SIZE + 1][16];
+    for(size_t i = 0; i <= TABLE_SMALL_SIZE; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "key%zu", i);
+      table_add(&table, keys[i], 100 + i);
+    }
+
+#if !defined(TABLE_INLINE_KEYS)
+    assert_that_size_t(sizeof(EmeraldsTableSlot) equals to 4 * sizeof(size_t));
+#endif
+    assert_that_size_t(
+      (size_t)table.states % TABLE_CACHE_LINE_SIZE equals to 0
+    );
+    assert_that_size_t((size_t)table.slots % TABLE_CACHE_LINE_SIZE equals to 0);
+    assert_that((void *)table.slots is(void *)(table.states + 1024));
+    assert_that_size_t(table_get(&table, "key1") equals to 101);
+
+    table_deinit(&table);
+    assert_that(table.block is NULL);
+  });
+#endif
+
+  it("takes every byte of storage from its allocator and gives it back", {
+    EmeraldsTableAllocator allocator = {
+      table_spec_allocate,
+      table_spec_reallocate,
+      table_spec_release,
+      &table_spec_outstanding
+    };
+    EmeraldsTable table;
+    char(*keys)[48] = malloc(5000 * sizeof(*keys));
+    table_init_with_allocator(&table, &allocator);
+    assert_that_size_t(table_spec_outstanding equals to 0);
+
+    for(size_t i = 0; i < 5000; i++) {
+      snprintf(
+        keys[i], sizeof(keys[i]), "allocated_key_%zu_with_a_long_tail", i
+      );
+      table_add(&table, keys[i], i);
+      if(i % 3 == 0) {
+        table_remove(&table, keys[i]);
+      }
+    }
+    assert_that(table_spec_outstanding > 0);
+    assert_that_size_t(table_size(&table) equals to 3333);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 5000; i++) {
+      mismatches += table_get(&table, keys[i]) != (i % 3 ? i : TABLE_UNDEFINED);
+    }
+    assert_that_size_t(mismatches equals to 0);
+
+    table_deinit(&table);
+    assert_that_size_t(table_spec_outstanding equals to 0);
+    free(keys);
   });
 
   it("handles simple inserts, lookups and removals", {
@@ -61,10 +196,171 @@ module(T_table, {
     assert_that(value2 is TABLE_UNDEFINED);
 
     table_deinit(&table);
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+    assert_that(table.slots is NULL);
+    assert_that(table.states is NULL);
+#else
     assert_that(table.hashes is NULL);
     assert_that(table.states is NULL);
     assert_that(table.keys is NULL);
     assert_that(table.values is NULL);
+#endif
+  });
+
+  it("uses slices of a larger buffer as keys", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    const char *source = "let abc = abcd + ab;";
+    table_add_n(&table, source + 4, 3, 1);
+    table_add_n(&table, source + 10, 4, 2);
+    table_add_n(&table, source + 17, 2, 3);
+
+    assert_that_size_t(table_size(&table) equals to 3);
+    assert_that_size_t(table_get_n(&table, "abc", 3) equals to 1);
+    assert_that_size_t(table_get_n(&table, "abcd", 4) equals to 2);
+    assert_that_size_t(table_get_n(&table, "abcdef", 2) equals to 3);
+    assert_that_size_t(table_get(&table, "abc") equals to 1);
+    assert_that_size_t(table_get_n(&table, "a", 1) equals to TABLE_UNDEFINED);
+
+    table_remove_n(&table, source + 10, 4);
+    assert_that_size_t(table_get(&table, "abcd") equals to TABLE_UNDEFINED);
+    assert_that_size_t(table_get(&table, "abc") equals to 1);
+
+    EmeraldsTable copy = {0};
+    table_init(&copy);
+    table_add_all(&table, &copy);
+    assert_that_size_t(table_get(&copy, "abc") equals to 1);
+    assert_that_size_t(table_get(&copy, "ab") equals to 3);
+
+    table_deinit(&copy);
+    table_deinit(&table);
+  });
+
+  it("probes a chain of tables with a key hashed once", {
+    EmeraldsTable scopes[3] = {{0}};
+    for(size_t i = 0; i < 3; i++) {
+      table_init(&scopes[i]);
+    }
+    table_add(&scopes[0], "global", 1);
+    table_add(&scopes[2], "local", 3);
+
+    EmeraldsTableKey global = table_key("global");
+    EmeraldsTableKey local  = table_key_n("local_variable", 5);
+    assert_that_size_t(global.length equals to 6);
+    assert_that_size_t(global.hash
+                         equals to TABLE_HASH_FUNCTION("global", 6));
+
+    assert_that_size_t(table_get_h(&scopes[0], &global) equals to 1);
+    assert_that_size_t(table_get_h(&scopes[1], &global)
+                         equals to TABLE_UNDEFINED);
+    assert_that_size_t(table_get_h(&scopes[2], &local) equals to 3);
+
+    table_add_h(&scopes[1], &local, 2);
+    assert_that_size_t(table_get(&scopes[1], "local") equals to 2);
+    table_remove_h(&scopes[2], &local);
+    assert_that_size_t(table_get_h(&scopes[2], &local)
+                         equals to TABLE_UNDEFINED);
+
+    for(size_t i = 0; i < 3; i++) {
+      table_deinit(&scopes[i]);
+    }
+  });
+
+  it("looks up a batch of keys", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char keys[100][16];
+    const char *batch[100];
+    size_t values[100];
+    for(size_t i = 0; i < 100; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "batch_%zu", i);
+      if(i % 2 == 0) {
+        table_add(&table, keys[i], i);
+      }
+      batch[i] = keys[i];
+    }
+
+    table_get_batch(&table, batch, 100, values);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 100; i++) {
+      size_t expected = (i % 2 == 0) ? i : TABLE_UNDEFINED;
+      if(values[i] != expected) {
+        mismatches++;
+      }
+    }
+    assert_that_size_t(mismatches equals to 0);
+
+    table_deinit(&table);
+  });
+
+  it("builds a table from arrays and adds batches to it", {
+    EmeraldsTable table = {0};
+
+    char keys[10000][16];
+    const char *batch[10000];
+    size_t values[10000];
+    for(size_t i = 0; i < 10000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "bulk_%zu", i);
+      batch[i]  = keys[i];
+      values[i] = i;
+    }
+
+    table_build_from_arrays(&table, batch, values, 5000);
+    assert_that_size_t(table.capacity equals to 8192);
+    assert_that_size_t(table_size(&table) equals to 5000);
+
+    table_add_batch(&table, batch + 4000, values + 4000, 6000);
+    assert_that_size_t(table.capacity equals to 16384);
+    assert_that_size_t(table_size(&table) equals to 10000);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 10000; i++) {
+      if(table_get(&table, keys[i]) != i) {
+        mismatches++;
+      }
+    }
+    assert_that_size_t(mismatches equals to 0);
+
+    table_add(&table, "after_bulk", 42);
+    assert_that_size_t(table_get(&table, "after_bulk") equals to 42);
+
+    table_deinit(&table);
+  });
+
+  it("does not grow when a batch only updates existing keys", {
+    EmeraldsTable table = {0};
+
+    char keys[6000][16];
+    const char *batch[6000];
+    size_t values[6000];
+    for(size_t i = 0; i < 6000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "upsert_%zu", i);
+      batch[i]  = keys[i];
+      values[i] = i;
+    }
+
+    table_build_from_arrays(&table, batch, values, 6000);
+    assert_that_size_t(table.capacity equals to 8192);
+
+    for(size_t i = 0; i < 6000; i++) {
+      values[i] = i + 1;
+    }
+    table_add_batch(&table, batch, values, 6000);
+    assert_that_size_t(table.capacity equals to 8192);
+    assert_that_size_t(table_size(&table) equals to 6000);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 6000; i++) {
+      if(table_get(&table, keys[i]) != i + 1) {
+        mismatches++;
+      }
+    }
+    assert_that_size_t(mismatches equals to 0);
+
+    table_deinit(&table);
   });
 
   it("adds all the keys and values of one hash table to another", {
@@ -186,6 +482,261 @@ module(T_table, {
     assert_that_size_t(table_get(&table, "abcdef") equals to 42);
   });
 
+  it("keeps every key reachable under insert/remove churn", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char keys[4096][16];
+    for(size_t i = 0; i < 4096; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "churn_%zu", i);
+    }
+
+    for(size_t round = 0; round < 8; round++) {
+      for(size_t i = 0; i < 4096; i++) {
+        table_add(&table, keys[i], i + round);
+      }
+      for(size_t i = 0; i < 4096; i += 2) {
+        table_remove(&table, keys[i]);
+      }
+      size_t mismatches = 0;
+      for(size_t i = 0; i < 4096; i++) {
+        size_t expected = (i % 2 == 0) ? TABLE_UNDEFINED : i + round;
+        if(table_get(&table, keys[i]) != expected) {
+          mismatches++;
+        }
+      }
+      assert_that_size_t(mismatches equals to 0);
+      assert_that_size_t(table_size(&table) equals to 2048);
+    }
+
+    table_deinit(&table);
+  });
+
+  it("purges tombstones instead of growing under churn at constant size", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char keys[2000][16];
+    char buffer[32];
+    for(size_t i = 0; i < 2000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "live_%zu", i);
+      table_add(&table, keys[i], i);
+    }
+
+    for(size_t round = 0; round < 100; round++) {
+      for(size_t i = 0; i < 1000; i++) {
+        snprintf(buffer, sizeof(buffer), "gone_%zu_%zu", round, i);
+        table_add_n(&table, buffer, strlen(buffer), i);
+        table_remove_n(&table, buffer, strlen(buffer));
+      }
+    }
+    /* At most one doubling leaves room for tombstones, later rehashes purge */
+    size_t capacity = table.capacity;
+    assert_that(capacity <= 8192);
+
+    table_compact(&table);
+    assert_that_size_t(table.tombstones equals to 0);
+    assert_that_size_t(table.capacity equals to capacity);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 2000; i++) {
+      mismatches += table_get(&table, keys[i]) != i;
+    }
+    assert_that_size_t(mismatches equals to 0);
+    assert_that_size_t(table_size(&table) equals to 2000);
+
+    table_deinit(&table);
+  });
+
+  it("shrinks after mass removal and on shrink_to_fit", {
+    const size_t n  = 20000;
+    char(*keys)[16] = malloc(n * sizeof(*keys));
+    EmeraldsTable table;
+    table_init(&table);
+
+    for(size_t i = 0; i < n; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "drain_%zu", i);
+      table_add(&table, keys[i], i);
+    }
+    assert_that_size_t(table.capacity equals to 32768);
+
+    for(size_t i = 1000; i < n; i++) {
+      table_remove(&table, keys[i]);
+    }
+    assert_that_size_t(table.capacity equals to 8192);
+
+    table_shrink_to_fit(&table);
+    assert_that_size_t(table.capacity equals to 2048);
+    assert_that_size_t(table.tombstones equals to 0);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < n; i++) {
+      size_t expected = i < 1000 ? i : TABLE_UNDEFINED;
+      mismatches += table_get(&table, keys[i]) != expected;
+    }
+    assert_that_size_t(mismatches equals to 0);
+    assert_that_size_t(table_size(&table) equals to 1000);
+
+    table_deinit(&table);
+    free(keys);
+  });
+
+#if TABLE_PROBING == TABLE_PROBING_ROBIN_HOOD
+  it("removes keys by backward shifting without leaving tombstones", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char keys[512][16];
+    for(size_t i = 0; i < 512; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "shift_%zu", i);
+      table_add(&table, keys[i], i);
+    }
+    for(size_t i = 0; i < 512; i += 3) {
+      table_remove(&table, keys[i]);
+    }
+
+    assert_that_size_t(table.tombstones equals to 0);
+    assert_that_size_t(table_size(&table) equals to 341);
+    assert_that_size_t(table_get(&table, keys[1]) equals to 1);
+    assert_that_size_t(table_get(&table, keys[3]) equals to TABLE_UNDEFINED);
+    assert_that_size_t(table_get(&table, keys[511]) equals to 511);
+
+    table_deinit(&table);
+  });
+#endif
+
+#if defined(TABLE_INLINE_KEYS)
+  it("stores short keys inside their slot", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char short_key[TABLE_INLINE_KEY_SIZE + 1];
+    char long_key[TABLE_INLINE_KEY_SIZE + 2];
+    memset(short_key, 's', TABLE_INLINE_KEY_SIZE);
+    short_key[TABLE_INLINE_KEY_SIZE] = '\0';
+    memset(long_key, 'l', TABLE_INLINE_KEY_SIZE + 1);
+    long_key[TABLE_INLINE_KEY_SIZE + 1] = '\0';
+
+    table_add(&table, short_key, 1);
+    table_add(&table, long_key, 2);
+    table_add(&table, "", 3);
+
+    size_t short_bucket = 0;
+    while(!TABLE_STATE_IS_FILLED(table.states[short_bucket]) ||
+          TABLE_LENGTH_AT(&table, short_bucket) != TABLE_INLINE_KEY_SIZE) {
+      short_bucket++;
+    }
+    const char *stored = TABLE_KEY_AT(&table, short_bucket);
+    assert_that((void *)stored is(void *)table.slots[short_bucket].key.bytes);
+    assert_that(strcmp(stored, short_key) == 0);
+
+    /* The inline copy survives the caller reusing its buffer */
+    short_key[0] = 'x';
+    assert_that_size_t(table_get(&table, "x") equals to TABLE_UNDEFINED);
+    short_key[0] = 's';
+    assert_that_size_t(table_get(&table, short_key) equals to 1);
+    assert_that_size_t(table_get(&table, long_key) equals to 2);
+    assert_that_size_t(table_get(&table, "") equals to 3);
+
+    table_deinit(&table);
+  });
+#endif
+
+#if defined(TABLE_KEY_PREFIX) && !defined(TABLE_OWNED_KEYS)
+  it("verifies keys of up to 8 bytes from the prefix cache alone", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char short_key[] = "prefix";
+    char long_key[]  = "prefix_and_tail";
+    table_add(&table, short_key, 1);
+    table_add(&table, long_key, 2);
+
+    /* Short keys are never dereferenced, long ones are past byte 8 */
+    short_key[0] = 'X';
+    long_key[10] = 'X';
+    assert_that_size_t(table_get(&table, "prefix") equals to 1);
+    assert_that_size_t(
+      table_get(&table, "prefix_and_tail") equals to TABLE_UNDEFINED
+    );
+
+    table_deinit(&table);
+  });
+#endif
+
+#if defined(TABLE_OWNED_KEYS)
+  it("owns copies of its keys in a compacting arena", {
+    EmeraldsTable table = {0};
+    table_init(&table);
+
+    char buffer[32];
+    for(size_t i = 0; i < 2000; i++) {
+      snprintf(buffer, sizeof(buffer), "owned_%zu", i);
+      table_add(&table, buffer, i);
+    }
+    strcpy(buffer, "overwritten");
+
+    assert_that_size_t(table_get(&table, "owned_0") equals to 0);
+    assert_that_size_t(table_get(&table, "owned_1999") equals to 1999);
+    assert_that_size_t(
+      table_get(&table, "overwritten") equals to TABLE_UNDEFINED
+    );
+
+    /* Churn at constant size must not grow the arena without bound */
+    for(size_t round = 0; round < 200; round++) {
+      for(size_t i = 0; i < 1000; i++) {
+        snprintf(buffer, sizeof(buffer), "churn_%zu_%zu", round, i);
+        table_add(&table, buffer, i);
+      }
+      for(size_t i = 0; i < 1000; i++) {
+        snprintf(buffer, sizeof(buffer), "churn_%zu_%zu", round, i);
+        table_remove(&table, buffer);
+      }
+    }
+
+    assert_that_size_t(table_size(&table) equals to 2000);
+    assert_that(table.arena.bytes < 8 * TABLE_ARENA_CHUNK_SIZE);
+    assert_that_size_t(table_get(&table, "owned_1234") equals to 1234);
+
+    table_deinit(&table);
+    assert_that(table.arena.chunk is NULL);
+  });
+#endif
+
+#if defined(TABLE_PARALLEL_REHASH)
+  it("grows with several threads and keeps every key reachable", {
+    const size_t n   = 400000;
+    char(*keys)[16]  = malloc(n * sizeof(*keys));
+    EmeraldsTable table;
+    table_init(&table);
+    table.rehash_threads = 4;
+
+    for(size_t i = 0; i < n; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "grow_%zu", i);
+      table_add(&table, keys[i], i);
+      if(i % 7 == 0) {
+        table_remove(&table, keys[i / 2]);
+      }
+    }
+
+    size_t mismatches = 0;
+    size_t expected_size = 0;
+    for(size_t i = 0; i < n; i++) {
+      bool removed = (i * 2 < n && (i * 2) % 7 == 0) ||
+                     (i * 2 + 1 < n && (i * 2 + 1) % 7 == 0);
+      size_t expected = removed ? TABLE_UNDEFINED : i;
+      mismatches += table_get(&table, keys[i]) != expected;
+      expected_size += !removed;
+    }
+    assert_that(table.capacity >= TABLE_PARALLEL_REHASH_MIN * 2);
+    assert_that_size_t(mismatches equals to 0);
+    assert_that_size_t(table_size(&table) equals to expected_size);
+
+    table_deinit(&table);
+    free(keys);
+  });
+#endif
+
   it("tests size", {
     EmeraldsTable table = {0};
     table_init(&table);
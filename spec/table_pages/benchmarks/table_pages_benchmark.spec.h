@@ -0,0 +1,93 @@
+#ifndef __TABLE_PAGES_BENCHMARK_SPEC_H_
+#define __TABLE_PAGES_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "../../table/benchmarks/table_general_benchmark.spec.h"
+
+#define PAGES_BENCHMARK_ITEMS  4000000
+#define PAGES_BENCHMARK_ROUNDS 4
+
+/* The anonymous memory of the process backed by transparent huge pages */
+static size_t pages_benchmark_huge_kb() {
+  char line[256];
+  size_t kb  = 0;
+  FILE *file = fopen("/proc/self/smaps_rollup", "r");
+  if(file == NULL) {
+    return 0;
+  }
+  while(fgets(line, sizeof(line), file)) {
+    if(sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) {
+      break;
+    }
+  }
+  fclose(file);
+  return kb;
+}
+
+/* Fills a table and looks every key up in hash, so random bucket, order */
+static void pages_benchmark_run(
+  const char *name,
+  const EmeraldsTableAllocator *allocator,
+  EmeraldsTableKey *handles
+) {
+  EmeraldsTable table;
+  size_t found = 0;
+  table_init_with_allocator(&table, allocator);
+
+  double start_time = get_time();
+  for(size_t i = 0; i < PAGES_BENCHMARK_ITEMS; i++) {
+    table_add_h(&table, &handles[i], i);
+  }
+  double end_time = get_time();
+  printf(
+    "Filling %d keys on %s took %f seconds, %zu MB on huge pages.\n",
+    PAGES_BENCHMARK_ITEMS,
+    name,
+    end_time - start_time,
+    pages_benchmark_huge_kb() / 1024
+  );
+
+  start_time = get_time();
+  for(size_t round = 0; round < PAGES_BENCHMARK_ROUNDS; round++) {
+    for(size_t i = 0; i < PAGES_BENCHMARK_ITEMS; i++) {
+      found += table_get_h(&table, &handles[i]) == i;
+    }
+  }
+  end_time = get_time();
+  printf(
+    "Random lookups on %s took %f ns each.\n",
+    name,
+    (end_time - start_time) * 1e9 /
+      ((double)PAGES_BENCHMARK_ITEMS * PAGES_BENCHMARK_ROUNDS)
+  );
+
+  assert_that_size_t(
+    found equals to(size_t) PAGES_BENCHMARK_ITEMS * PAGES_BENCHMARK_ROUNDS
+  );
+  table_deinit(&table);
+}
+
+module(T_table_pages_benchmark, {
+  it("benchmarks large table lookups with and without huge pages", {
+    char(*names)[16] = malloc(PAGES_BENCHMARK_ITEMS * sizeof(*names));
+    EmeraldsTableKey *handles =
+      malloc(PAGES_BENCHMARK_ITEMS * sizeof(EmeraldsTableKey));
+    EmeraldsTablePages pages;
+
+    for(size_t i = 0; i < PAGES_BENCHMARK_ITEMS; i++) {
+      snprintf(names[i], sizeof(names[i]), "page_%zu", i);
+      handles[i] = table_key(names[i]);
+    }
+    table_pages_init(&pages, false);
+
+    printf("RUNNING HUGE PAGE BENCHMARKS\n");
+    pages_benchmark_run("4 KB pages", NULL, handles);
+    pages_benchmark_run("2 MB pages", table_pages_allocator(&pages), handles);
+
+    free(handles);
+    free(names);
+  });
+})
+
+#endif
@@ -0,0 +1,106 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+module(T_table_pages, {
+  it("maps large tables on huge page boundaries and unmaps them", {
+    EmeraldsTablePages pages;
+    EmeraldsTable table;
+    char(*keys)[16] = malloc(200000 * sizeof(*keys));
+    table_pages_init(&pages, false);
+    table_init_with_allocator(&table, table_pages_allocator(&pages));
+
+    for(size_t i = 0; i < 200000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "paged_%zu", i);
+      table_add(&table, keys[i], i);
+    }
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 200000; i++) {
+      mismatches += table_get(&table, keys[i]) != i;
+    }
+    assert_that_size_t(mismatches equals to 0);
+#if defined(__linux__)
+    assert_that(pages.mapped > 0);
+    assert_that_size_t(pages.mapped % TABLE_PAGES_HUGE_SIZE equals to 0);
+  #if defined(TABLE_LAYOUT_INTERLEAVED)
+    assert_that_size_t(
+      (size_t)table.block % TABLE_PAGES_HUGE_SIZE equals to 0
+    );
+  #else
+    assert_that_size_t(
+      (size_t)table.hashes % TABLE_PAGES_HUGE_SIZE equals to 0
+    );
+  #endif
+#endif
+
+    table_deinit(&table);
+    assert_that_size_t(pages.mapped equals to 0);
+    free(keys);
+  });
+
+  it("keeps small blocks on malloc", {
+    EmeraldsTablePages pages;
+    EmeraldsTable table;
+    table_pages_init(&pages, false);
+    table_init_with_allocator(&table, table_pages_allocator(&pages));
+
+    table_add(&table, "small", 1);
+    table_add(&table, "table", 2);
+    assert_that_size_t(table_get(&table, "table") equals to 2);
+    assert_that_size_t(pages.mapped equals to 0);
+    table_deinit(&table);
+  });
+
+  it("remaps large blocks when they grow or shrink", {
+    EmeraldsTablePages pages;
+    table_pages_init(&pages, false);
+    const EmeraldsTableAllocator *allocator = table_pages_allocator(&pages);
+
+    size_t bytes = 2 * TABLE_PAGES_HUGE_SIZE;
+    size_t *block = allocator->allocate(allocator->context, bytes);
+    for(size_t i = 0; i < bytes / sizeof(size_t); i++) {
+      block[i] = i;
+    }
+    block = allocator->reallocate(allocator->context, block, bytes, 4 * bytes);
+    size_t mismatches = 0;
+    for(size_t i = 0; i < bytes / sizeof(size_t); i++) {
+      mismatches += block[i] != i;
+    }
+    assert_that_size_t(mismatches equals to 0);
+    block[4 * bytes / sizeof(size_t) - 1] = 1;
+#if defined(__linux__)
+    assert_that_size_t((size_t)block % TABLE_PAGES_HUGE_SIZE equals to 0);
+    assert_that_size_t(pages.mapped equals to 4 * bytes);
+#endif
+
+    block = allocator->reallocate(allocator->context, block, 4 * bytes, bytes);
+    assert_that_size_t(block[bytes / sizeof(size_t) - 1] equals to
+                         bytes / sizeof(size_t) - 1);
+#if defined(__linux__)
+    assert_that_size_t(pages.mapped equals to bytes);
+#endif
+    allocator->release(allocator->context, block, bytes);
+    assert_that_size_t(pages.mapped equals to 0);
+  });
+
+  it("falls back to usable memory without hugetlb pages or NUMA", {
+    EmeraldsTablePages pages;
+    table_pages_init(&pages, true);
+    table_pages_numa(&pages, TABLE_PAGES_NUMA_INTERLEAVE, 1);
+    const EmeraldsTableAllocator *allocator = table_pages_allocator(&pages);
+
+    size_t bytes = 3 * TABLE_PAGES_HUGE_SIZE + 1;
+    char *block  = allocator->allocate(allocator->context, bytes);
+    assert_that(block isnot NULL);
+    memset(block, 'p', bytes);
+    assert_that_int(block[bytes - 1] equals to 'p');
+    assert_that(
+      allocator->reallocate(allocator->context, block, bytes, bytes + 100)
+        is block
+    );
+
+    block = allocator->reallocate(allocator->context, block, bytes + 100, 64);
+    assert_that_int(block[63] equals to 'p');
+    assert_that_size_t(pages.mapped equals to 0);
+    allocator->release(allocator->context, block, 64);
+  });
+})
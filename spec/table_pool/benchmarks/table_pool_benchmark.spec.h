@@ -0,0 +1,68 @@
+#ifndef __TABLE_POOL_BENCHMARK_SPEC_H_
+#define __TABLE_POOL_BENCHMARK_SPEC_H_
+
+#include "../../../libs/cSpec/export/cSpec.h"
+#include "../../../src/EmeraldsTable.h"
+#include "../../table/benchmarks/table_general_benchmark.spec.h"
+
+#define POOL_BENCHMARK_CYCLES  100000
+#define POOL_BENCHMARK_ENTRIES 64
+
+/* Creates, fills, probes and destroys one table per cycle */
+static size_t pool_benchmark_cycles(
+  const EmeraldsTableAllocator *allocator, EmeraldsTableKey *handles
+) {
+  size_t found = 0;
+  for(size_t cycle = 0; cycle < POOL_BENCHMARK_CYCLES; cycle++) {
+    EmeraldsTable table;
+    table_init_with_allocator(&table, allocator);
+    for(size_t i = 0; i < POOL_BENCHMARK_ENTRIES; i++) {
+      table_add_h(&table, &handles[i], i);
+    }
+    found += table_get_h(&table, &handles[cycle % POOL_BENCHMARK_ENTRIES]) !=
+             TABLE_UNDEFINED;
+    table_deinit(&table);
+  }
+  return found;
+}
+
+module(T_table_pool_benchmark, {
+  it("benchmarks short lived tables with and without a pool", {
+    char names[POOL_BENCHMARK_ENTRIES][16];
+    EmeraldsTableKey handles[POOL_BENCHMARK_ENTRIES];
+    EmeraldsTablePool pool;
+    size_t found = 0;
+
+    for(size_t i = 0; i < POOL_BENCHMARK_ENTRIES; i++) {
+      snprintf(names[i], sizeof(names[i]), "local_%zu", i);
+      handles[i] = table_key(names[i]);
+    }
+    table_pool_init(&pool, 0);
+
+    printf("RUNNING TABLE POOL BENCHMARKS\n");
+
+    double start_time = get_time();
+    found += pool_benchmark_cycles(NULL, handles);
+    double end_time = get_time();
+    printf(
+      "%d table lifetimes on malloc took %f seconds.\n",
+      POOL_BENCHMARK_CYCLES,
+      end_time - start_time
+    );
+
+    start_time = get_time();
+    found += pool_benchmark_cycles(table_pool_allocator(&pool), handles);
+    end_time = get_time();
+    printf(
+      "%d table lifetimes on a pool took %f seconds, %zu system allocations.\n",
+      POOL_BENCHMARK_CYCLES,
+      end_time - start_time,
+      pool.misses
+    );
+
+    assert_that_size_t(found equals to 2 * POOL_BENCHMARK_CYCLES);
+    table_pool_deinit(&pool);
+  });
+})
+
+#endif
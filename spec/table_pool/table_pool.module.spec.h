@@ -0,0 +1,97 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+module(T_table_pool, {
+  it("hands the storage of a released table to the next one", {
+    EmeraldsTablePool pool;
+    EmeraldsTable table;
+    char keys[100][16];
+    table_pool_init(&pool, 0);
+
+    for(size_t i = 0; i < 100; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "pooled_%zu", i);
+    }
+    table_init_with_allocator(&table, table_pool_allocator(&pool));
+    for(size_t i = 0; i < 100; i++) {
+      table_add(&table, keys[i], i);
+    }
+    table_deinit(&table);
+    size_t misses = pool.misses;
+    assert_that(misses > 0);
+    assert_that(pool.cached > 0);
+
+    for(size_t round = 0; round < 10; round++) {
+      table_init_with_allocator(&table, table_pool_allocator(&pool));
+      for(size_t i = 0; i < 100; i++) {
+        table_add(&table, keys[i], i + round);
+      }
+      size_t mismatches = 0;
+      for(size_t i = 0; i < 100; i++) {
+        mismatches += table_get(&table, keys[i]) != i + round;
+      }
+      assert_that_size_t(mismatches equals to 0);
+      table_deinit(&table);
+    }
+    assert_that_size_t(pool.misses equals to misses);
+
+    table_pool_deinit(&pool);
+    assert_that_size_t(pool.cached equals to 0);
+  });
+
+  it("grows and shrinks tables through the pool", {
+    EmeraldsTablePool pool;
+    EmeraldsTable table;
+    char(*keys)[16] = malloc(20000 * sizeof(*keys));
+    table_pool_init(&pool, 0);
+    table_init_with_allocator(&table, table_pool_allocator(&pool));
+
+    for(size_t i = 0; i < 20000; i++) {
+      snprintf(keys[i], sizeof(keys[i]), "grown_%zu", i);
+      table_add(&table, keys[i], i);
+    }
+    for(size_t i = 1000; i < 20000; i++) {
+      table_remove(&table, keys[i]);
+    }
+    table_shrink_to_fit(&table);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < 20000; i++) {
+      size_t expected = i < 1000 ? i : TABLE_UNDEFINED;
+      mismatches += table_get(&table, keys[i]) != expected;
+    }
+    assert_that_size_t(mismatches equals to 0);
+
+    table_deinit(&table);
+    table_pool_deinit(&pool);
+    free(keys);
+  });
+
+  it("rounds blocks up to size classes and keeps contents on reallocate", {
+    EmeraldsTablePool pool;
+    table_pool_init(&pool, 1 << 12);
+    const EmeraldsTableAllocator *allocator = table_pool_allocator(&pool);
+
+    char *block = allocator->allocate(allocator->context, 100);
+    memset(block, 'x', 100);
+    /* 100 bytes land in the 112 byte class, growing within it keeps it */
+    assert_that(
+      allocator->reallocate(allocator->context, block, 100, 112) is block
+    );
+    block = allocator->reallocate(allocator->context, block, 112, 1000);
+    assert_that_size_t(block[0] equals to 'x');
+    assert_that_size_t(block[99] equals to 'x');
+    assert_that_size_t(pool.cached equals to 112);
+
+    allocator->release(allocator->context, block, 1000);
+    assert_that_size_t(pool.cached equals to 112 + 1024);
+
+    /* Past the limit blocks go straight back to the system */
+    block = allocator->allocate(allocator->context, 4000);
+    allocator->release(allocator->context, block, 4000);
+    assert_that_size_t(pool.cached equals to 112 + 1024);
+
+    table_pool_trim(&pool);
+    assert_that_size_t(pool.cached equals to 0);
+    table_pool_deinit(&pool);
+  });
+})
@@ -0,0 +1,125 @@
+#include "../../libs/cSpec/export/cSpec.h"
+#include "../../src/EmeraldsTable.h"
+
+#define typed_spec_string_hash(key) (komihash_hash((key), strlen(key)))
+#define typed_spec_string_eq(a, b)  (strcmp((a), (b)) == 0)
+#define typed_spec_int_hash(key)    ((size_t)(key) * 0x9e3779b97f4a7c15)
+#define typed_spec_int_eq(a, b)     ((a) == (b))
+
+TABLE_DEFINE(
+  TypedSpecStringTable,
+  typed_spec_string_table,
+  const char *,
+  uint32_t,
+  typed_spec_string_hash,
+  typed_spec_string_eq
+);
+
+TABLE_DEFINE_TUNED(
+  TypedSpecIntTable,
+  typed_spec_int_table,
+  uint64_t,
+  uint16_t,
+  typed_spec_int_hash,
+  typed_spec_int_eq,
+  0.5,
+  16
+);
+
+TABLE_DEFINE_TUNED(
+  TypedSpecFullTable,
+  typed_spec_full_table,
+  uint64_t,
+  uint64_t,
+  typed_spec_int_hash,
+  typed_spec_int_eq,
+  1.0,
+  8
+);
+
+module(T_typed_table, {
+  it("generates a string keyed table with narrow values", {
+    TypedSpecStringTable table = {0};
+    typed_spec_string_table_init(&table);
+
+    assert_that_size_t(sizeof(*table.values) equals to sizeof(uint32_t));
+    assert_that_size_t(table.capacity equals to TABLE_INITIAL_SIZE);
+
+    typed_spec_string_table_add(&table, "key1", 100);
+    typed_spec_string_table_add(&table, "key2", 200);
+    typed_spec_string_table_add(&table, "key1", 101);
+
+    assert_that_size_t(typed_spec_string_table_size(&table) equals to 2);
+    assert_that_size_t(*typed_spec_string_table_get(&table, "key1")
+                         equals to 101);
+    assert_that_size_t(*typed_spec_string_table_get(&table, "key2")
+                         equals to 200);
+    assert_that(typed_spec_string_table_get(&table, "key3") is NULL);
+
+    assert_that(typed_spec_string_table_remove(&table, "key1"));
+    assert_that(!typed_spec_string_table_remove(&table, "key1"));
+    assert_that(typed_spec_string_table_get(&table, "key1") is NULL);
+    assert_that_size_t(typed_spec_string_table_size(&table) equals to 1);
+
+    typed_spec_string_table_deinit(&table);
+    assert_that(table.keys is NULL);
+  });
+
+  it("generates an integer keyed table with its own tuning", {
+    TypedSpecIntTable table = {0};
+    typed_spec_int_table_init(&table);
+    assert_that_size_t(table.capacity equals to 16);
+
+    for(uint64_t i = 0; i < 1000; i++) {
+      typed_spec_int_table_add(&table, i * 7, (uint16_t)i);
+    }
+    assert_that_size_t(typed_spec_int_table_size(&table) equals to 1000);
+    assert_that_size_t(table.capacity equals to 2048);
+
+    size_t mismatches = 0;
+    for(uint64_t i = 0; i < 1000; i++) {
+      uint16_t *value = typed_spec_int_table_get(&table, i * 7);
+      if(value == NULL || *value != i) {
+        mismatches++;
+      }
+    }
+    assert_that_size_t(mismatches equals to 0);
+    assert_that(typed_spec_int_table_get(&table, 1) is NULL);
+
+    for(uint64_t i = 0; i < 1000; i += 2) {
+      typed_spec_int_table_remove(&table, i * 7);
+    }
+    assert_that_size_t(typed_spec_int_table_size(&table) equals to 500);
+    assert_that(typed_spec_int_table_get(&table, 0) is NULL);
+    assert_that_size_t(*typed_spec_int_table_get(&table, 7) equals to 1);
+
+    typed_spec_int_table_deinit(&table);
+  });
+
+  it("keeps an empty bucket with a load factor of 1", {
+    TypedSpecFullTable table = {0};
+    typed_spec_full_table_init(&table);
+
+    for(uint64_t i = 0; i < 9; i++) {
+      typed_spec_full_table_add(&table, i, i + 1);
+    }
+    assert_that_size_t(typed_spec_full_table_size(&table) equals to 9);
+    assert_that_size_t(table.capacity equals to 16);
+    assert_that(typed_spec_full_table_get(&table, 9) is NULL);
+
+    /* Churn at 7 live keys of 8 buckets, misses still end on an empty one */
+    typed_spec_full_table_deinit(&table);
+    typed_spec_full_table_init(&table);
+    for(uint64_t i = 0; i < 1000; i++) {
+      typed_spec_full_table_add(&table, i, i + 1);
+      if(i >= 7) {
+        typed_spec_full_table_remove(&table, i - 7);
+      }
+    }
+    assert_that_size_t(typed_spec_full_table_size(&table) equals to 7);
+    assert_that_size_t(*typed_spec_full_table_get(&table, 999) equals to 1000);
+    assert_that(typed_spec_full_table_get(&table, 992) is NULL);
+
+    typed_spec_full_table_deinit(&table);
+  });
+})
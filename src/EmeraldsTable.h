@@ -28,6 +28,15 @@
 #ifndef __EMERALDS_HASHTABLE_H_
 #define __EMERALDS_HASHTABLE_H_
 
+#include "concurrent_table/concurrent_table.h"
+#include "frozen_table/frozen_table.h"
+#include "int_table/int_table.h"
+#include "mapped_table/mapped_table.h"
+#include "rcu_table/rcu_table.h"
+#include "sharded_table/sharded_table.h"
 #include "table/table.h"
+#include "table_pages/table_pages.h"
+#include "table_pool/table_pool.h"
+#include "typed_table/typed_table.h"
 
 #endif
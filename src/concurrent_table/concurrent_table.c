@@ -0,0 +1,571 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "concurrent_table.h"
+
+#if defined(CONCURRENT_TABLE_AVAILABLE)
+
+  #if defined(_WIN32)
+    #include <windows.h>
+    #define _concurrent_table_yield() SwitchToThread()
+  #else
+    #include <sched.h>
+    #define _concurrent_table_yield() sched_yield()
+  #endif
+
+/** @brief Tells the core it sits in a spin loop, a no-op where unknown */
+  #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define _concurrent_table_relax() __builtin_ia32_pause()
+  #elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define _concurrent_table_relax() _mm_pause()
+  #elif defined(__GNUC__) && defined(__aarch64__)
+    #define _concurrent_table_relax() __asm__ __volatile__("yield")
+  #else
+    #define _concurrent_table_relax() ((void)0)
+  #endif
+
+/** @brief Hash of a bucket that a resize closed while it was still empty */
+  #define _CONCURRENT_TABLE_CLOSED ((size_t)1)
+
+/** @brief Probe result telling the caller to continue in the next array */
+  #define _CONCURRENT_TABLE_FORWARD ((size_t)-1)
+
+/**
+ * @brief Keeps key hashes clear of the empty and closed markers
+ * @param hash -> The TABLE_HASH_FUNCTION hash
+ * @return size_t -> The hash stored in the bucket
+ */
+  #define _concurrent_table_stored_hash(hash) \
+    ((hash) > _CONCURRENT_TABLE_CLOSED ? (hash) : (hash) + 2)
+
+/**
+ * @brief Waits for the thread that claimed a bucket to publish its key, it is
+ * a few stores away so spin first, then yield in case it got preempted
+ * @param slot -> The claimed bucket
+ * @return const char * -> The published key
+ */
+static const char *_concurrent_table_wait_key(EmeraldsConcurrentSlot *slot) {
+  const char *key;
+  size_t spins = 0;
+  while((key = atomic_load_explicit(&slot->key, memory_order_acquire)) ==
+        NULL) {
+    if(spins < CONCURRENT_TABLE_SPIN_LIMIT) {
+      _concurrent_table_relax();
+      spins++;
+    } else {
+      _concurrent_table_yield();
+    }
+  }
+  return key;
+}
+
+/**
+ * @brief Allocates an empty bucket array
+ * @param capacity -> The bucket count, a power of two
+ * @return EmeraldsConcurrentBuckets * -> The array
+ */
+static EmeraldsConcurrentBuckets *_concurrent_table_allocate(size_t capacity) {
+  size_t i;
+  EmeraldsConcurrentBuckets *buckets =
+    (EmeraldsConcurrentBuckets *)malloc(sizeof(EmeraldsConcurrentBuckets));
+  buckets->slots = (EmeraldsConcurrentSlot *)malloc(
+    capacity * sizeof(EmeraldsConcurrentSlot)
+  );
+  for(i = 0; i < capacity; i++) {
+    atomic_init(&buckets->slots[i].hash, 0);
+    atomic_init(&buckets->slots[i].key, NULL);
+    buckets->slots[i].length = 0;
+    atomic_init(&buckets->slots[i].value, TABLE_UNDEFINED);
+    atomic_init(&buckets->slots[i].frozen, TABLE_UNDEFINED);
+  }
+  buckets->capacity = capacity;
+  atomic_init(&buckets->claimed, 0);
+  atomic_init(&buckets->next, NULL);
+  atomic_init(&buckets->transfer_index, 0);
+  atomic_init(&buckets->transferred, 0);
+  atomic_init(&buckets->retired_epoch, CONCURRENT_TABLE_LIVE);
+  return buckets;
+}
+
+/**
+ * @brief Deallocates a bucket array
+ * @param buckets -> The array
+ */
+static void _concurrent_table_free(EmeraldsConcurrentBuckets *buckets) {
+  free(buckets->slots);
+  free(buckets);
+}
+
+/**
+ * @brief Announces an operation, arrays it can reach stay allocated until it
+ * leaves again
+ * @param self -> The table
+ * @return size_t -> The epoch the operation runs in
+ */
+static size_t _concurrent_table_enter(EmeraldsConcurrentTable *self) {
+  while(true) {
+    size_t epoch = atomic_load(&self->epoch);
+    atomic_fetch_add(&self->operations[epoch & 1].count, 1);
+    if(atomic_load(&self->epoch) == epoch) {
+      return epoch;
+    }
+    /* Counted under an epoch that already ended, count again */
+    atomic_fetch_sub(&self->operations[epoch & 1].count, 1);
+  }
+}
+
+/**
+ * @brief Advances the epoch once the previous one has no operations left and
+ * frees the arrays retired two epochs ago or earlier, which no running
+ * operation can reach anymore, only one thread reclaims at a time
+ * @param self -> The table
+ */
+static void _concurrent_table_reclaim(EmeraldsConcurrentTable *self) {
+  size_t epoch;
+  EmeraldsConcurrentBuckets *oldest;
+
+  if(atomic_load(&self->generations) == atomic_load(&self->buckets) ||
+     atomic_exchange(&self->reclaiming, true)) {
+    return;
+  }
+
+  epoch = atomic_load(&self->epoch);
+  if(atomic_load(&self->operations[(epoch - 1) & 1].count) == 0) {
+    atomic_compare_exchange_strong(&self->epoch, &epoch, epoch + 1);
+  }
+  epoch  = atomic_load(&self->epoch);
+  oldest = atomic_load(&self->generations);
+  while(oldest != atomic_load(&self->buckets)) {
+    size_t retired_epoch = atomic_load(&oldest->retired_epoch);
+    if(retired_epoch == CONCURRENT_TABLE_LIVE || retired_epoch + 2 > epoch) {
+      break;
+    }
+    atomic_store(&self->generations, atomic_load(&oldest->next));
+    _concurrent_table_free(oldest);
+    oldest = atomic_load(&self->generations);
+  }
+  atomic_store(&self->reclaiming, false);
+}
+
+/**
+ * @brief Ends an operation and lets it reclaim retired arrays
+ * @param self -> The table
+ * @param epoch -> The epoch returned by _concurrent_table_enter
+ */
+static void
+_concurrent_table_leave(EmeraldsConcurrentTable *self, size_t epoch) {
+  atomic_fetch_sub(&self->operations[epoch & 1].count, 1);
+  _concurrent_table_reclaim(self);
+}
+
+/**
+ * @brief Chains a bigger (or, after many removals, equally sized) array to a
+ * full one, the first thread to get there wins
+ * @param self -> The table
+ * @param buckets -> The full array
+ */
+static void _concurrent_table_start_resize(
+  EmeraldsConcurrentTable *self, EmeraldsConcurrentBuckets *buckets
+) {
+  size_t size;
+  size_t capacity;
+  EmeraldsConcurrentBuckets *expected = NULL;
+  EmeraldsConcurrentBuckets *next;
+
+  if(atomic_load(&buckets->next) != NULL) {
+    return;
+  }
+
+  size     = atomic_load(&self->size);
+  capacity = buckets->capacity;
+  while(size * 2 > capacity * TABLE_LOAD_FACTOR) {
+    capacity *= 2;
+  }
+
+  next = _concurrent_table_allocate(capacity);
+  if(!atomic_compare_exchange_strong(&buckets->next, &expected, next)) {
+    _concurrent_table_free(next);
+  }
+}
+
+/**
+ * @brief Probes an array for a key, optionally claiming the first empty bucket
+ * @param self -> The table
+ * @param buckets -> The array
+ * @param hash -> The stored hash of the key
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param claim -> Whether a missing key gets a bucket
+ * @param value -> The value a claimed bucket starts with
+ * @param inserted -> Set when the bucket got claimed by this call
+ * @return size_t -> The bucket, TABLE_UNDEFINED when missing and not claimed or
+ * _CONCURRENT_TABLE_FORWARD when the array is closed for this key
+ */
+static size_t _concurrent_table_find(
+  EmeraldsConcurrentTable *self,
+  EmeraldsConcurrentBuckets *buckets,
+  size_t hash,
+  const char *key,
+  size_t keylen,
+  bool claim,
+  size_t value,
+  bool *inserted
+) {
+  size_t probes;
+  size_t mask         = buckets->capacity - 1;
+  size_t bucket_index = hash & mask;
+  *inserted           = false;
+
+  for(probes = 0; probes < buckets->capacity; probes++) {
+    EmeraldsConcurrentSlot *slot = &buckets->slots[bucket_index];
+    size_t current               = atomic_load(&slot->hash);
+
+    if(current == 0) {
+      if(!claim) {
+        return TABLE_UNDEFINED;
+      }
+      if(atomic_compare_exchange_strong(&slot->hash, &current, hash)) {
+        slot->length = keylen;
+        atomic_store_explicit(&slot->value, value, memory_order_relaxed);
+        atomic_store_explicit(&slot->key, key, memory_order_release);
+        *inserted = true;
+        if(atomic_fetch_add(&buckets->claimed, 1) + 1 >
+           buckets->capacity * TABLE_LOAD_FACTOR) {
+          _concurrent_table_start_resize(self, buckets);
+        }
+        return bucket_index;
+      }
+      /* Lost the race, `current` now holds the winner's hash */
+    }
+
+    if(current == _CONCURRENT_TABLE_CLOSED) {
+      return _CONCURRENT_TABLE_FORWARD;
+    } else if(current == hash) {
+      const char *stored = _concurrent_table_wait_key(slot);
+      if(slot->length == keylen && memcmp(stored, key, keylen) == 0) {
+        return bucket_index;
+      }
+    }
+    bucket_index = (bucket_index + 1) & mask;
+  }
+
+  _concurrent_table_start_resize(self, buckets);
+  return _CONCURRENT_TABLE_FORWARD;
+}
+
+static void _concurrent_table_help(
+  EmeraldsConcurrentTable *self, EmeraldsConcurrentBuckets *buckets
+);
+
+/**
+ * @brief Moves one bucket, empty ones get closed and filled ones frozen with
+ * CONCURRENT_TABLE_MOVED before their last value is copied if still absent
+ * @param self -> The table
+ * @param buckets -> The array being drained
+ * @param bucket_index -> The bucket
+ */
+static void _concurrent_table_transfer_bucket(
+  EmeraldsConcurrentTable *self,
+  EmeraldsConcurrentBuckets *buckets,
+  size_t bucket_index
+) {
+  bool inserted;
+  const char *key;
+  size_t value;
+  size_t hash                  = 0;
+  EmeraldsConcurrentSlot *slot = &buckets->slots[bucket_index];
+  EmeraldsConcurrentBuckets *next;
+
+  if(atomic_compare_exchange_strong(
+       &slot->hash, &hash, _CONCURRENT_TABLE_CLOSED
+     )) {
+    return;
+  }
+  key = _concurrent_table_wait_key(slot);
+
+  value = atomic_load(&slot->value);
+  do {
+    atomic_store_explicit(&slot->frozen, value, memory_order_relaxed);
+  } while(!atomic_compare_exchange_weak(
+    &slot->value, &value, CONCURRENT_TABLE_MOVED
+  ));
+
+  if(value == TABLE_UNDEFINED) {
+    return;
+  }
+
+  /* A writer that got there first after the freeze holds a newer value */
+  next = atomic_load(&buckets->next);
+  while(_concurrent_table_find(
+          self, next, hash, key, slot->length, true, value, &inserted
+        ) == _CONCURRENT_TABLE_FORWARD) {
+    _concurrent_table_help(self, next);
+    next = atomic_load(&next->next);
+  }
+}
+
+/**
+ * @brief Replaces the published array with its successor for as long as the
+ * published one has been drained completely
+ * @param self -> The table
+ */
+static void _concurrent_table_promote(EmeraldsConcurrentTable *self) {
+  EmeraldsConcurrentBuckets *buckets = atomic_load(&self->buckets);
+  EmeraldsConcurrentBuckets *next    = atomic_load(&buckets->next);
+
+  while(next != NULL &&
+        atomic_load(&buckets->transferred) == buckets->capacity) {
+    if(!atomic_compare_exchange_strong(&self->buckets, &buckets, next)) {
+      return;
+    }
+    atomic_store(&buckets->retired_epoch, atomic_load(&self->epoch));
+    buckets = next;
+    next    = atomic_load(&buckets->next);
+  }
+}
+
+/**
+ * @brief Claims and moves chunks of a resizing array until none are left
+ * @param self -> The table
+ * @param buckets -> The resizing array
+ */
+static void _concurrent_table_help(
+  EmeraldsConcurrentTable *self, EmeraldsConcurrentBuckets *buckets
+) {
+  while(true) {
+    size_t i;
+    size_t end;
+    size_t start = atomic_fetch_add(
+      &buckets->transfer_index, CONCURRENT_TABLE_TRANSFER_STRIDE
+    );
+    if(start >= buckets->capacity) {
+      break;
+    }
+
+    end = start + CONCURRENT_TABLE_TRANSFER_STRIDE;
+    if(end > buckets->capacity) {
+      end = buckets->capacity;
+    }
+    for(i = start; i < end; i++) {
+      _concurrent_table_transfer_bucket(self, buckets, i);
+    }
+    atomic_fetch_add(&buckets->transferred, end - start);
+  }
+  _concurrent_table_promote(self);
+}
+
+/**
+ * @brief Applies a change of value to the size
+ * @param self -> The table
+ * @param prev -> The previous value
+ * @param value -> The new value
+ */
+static void _concurrent_table_count(
+  EmeraldsConcurrentTable *self, size_t prev, size_t value
+) {
+  if(prev == TABLE_UNDEFINED && value != TABLE_UNDEFINED) {
+    atomic_fetch_add(&self->size, 1);
+  } else if(prev != TABLE_UNDEFINED && value == TABLE_UNDEFINED) {
+    atomic_fetch_sub(&self->size, 1);
+  }
+}
+
+/**
+ * @brief Sets the value of a key, TABLE_UNDEFINED removes it, following moved
+ * entries into newer arrays where a copy might still be missing
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The new value
+ */
+static void _concurrent_table_update(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen, size_t value
+) {
+  bool inserted;
+  size_t bucket_index;
+  size_t hash = _concurrent_table_stored_hash(TABLE_HASH_FUNCTION(key, keylen));
+  bool claim  = value != TABLE_UNDEFINED;
+  size_t prev = TABLE_UNDEFINED;
+  EmeraldsConcurrentBuckets *buckets = atomic_load(&self->buckets);
+
+  if(atomic_load(&buckets->next) != NULL) {
+    _concurrent_table_help(self, buckets);
+    buckets = atomic_load(&self->buckets);
+  }
+
+  while(true) {
+    EmeraldsConcurrentSlot *slot;
+    size_t current;
+
+    bucket_index = _concurrent_table_find(
+      self, buckets, hash, key, keylen, claim, value, &inserted
+    );
+    if(bucket_index == _CONCURRENT_TABLE_FORWARD) {
+      _concurrent_table_help(self, buckets);
+      buckets = atomic_load(&buckets->next);
+      continue;
+    } else if(bucket_index == TABLE_UNDEFINED) {
+      return;
+    } else if(inserted) {
+      _concurrent_table_count(self, prev, value);
+      return;
+    }
+
+    slot    = &buckets->slots[bucket_index];
+    current = atomic_load(&slot->value);
+    while(current != CONCURRENT_TABLE_MOVED &&
+          !atomic_compare_exchange_weak(&slot->value, &current, value)) {
+    }
+    if(current != CONCURRENT_TABLE_MOVED) {
+      _concurrent_table_count(self, current, value);
+      return;
+    }
+
+    /* Frozen by a resize, the newer array might not have the copy yet */
+    prev  = atomic_load(&slot->frozen);
+    claim = true;
+    _concurrent_table_help(self, buckets);
+    buckets = atomic_load(&buckets->next);
+  }
+}
+
+/**
+ * @brief Looks a key up in an array and the ones chained after it
+ * @param buckets -> The array
+ * @param hash -> The stored hash of the key
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param fallback -> The value when no newer array has the key
+ * @return size_t -> The value
+ */
+static size_t _concurrent_table_lookup(
+  EmeraldsConcurrentBuckets *buckets,
+  size_t hash,
+  const char *key,
+  size_t keylen,
+  size_t fallback
+) {
+  size_t probes;
+  size_t mask         = buckets->capacity - 1;
+  size_t bucket_index = hash & mask;
+
+  for(probes = 0; probes < buckets->capacity; probes++) {
+    EmeraldsConcurrentSlot *slot = &buckets->slots[bucket_index];
+    size_t current               = atomic_load(&slot->hash);
+
+    if(current == 0) {
+      return fallback;
+    } else if(current == _CONCURRENT_TABLE_CLOSED) {
+      break;
+    } else if(current == hash) {
+      /* An unpublished key is an insert that has not happened yet */
+      const char *stored =
+        atomic_load_explicit(&slot->key, memory_order_acquire);
+      if(stored != NULL && slot->length == keylen &&
+         memcmp(stored, key, keylen) == 0) {
+        size_t value = atomic_load(&slot->value);
+        if(value != CONCURRENT_TABLE_MOVED) {
+          return value;
+        }
+        fallback = atomic_load(&slot->frozen);
+        break;
+      }
+    }
+    bucket_index = (bucket_index + 1) & mask;
+  }
+
+  buckets = atomic_load(&buckets->next);
+  return buckets != NULL
+           ? _concurrent_table_lookup(buckets, hash, key, keylen, fallback)
+           : fallback;
+}
+
+/**
+ * @brief Sets the value of a key inside an announced operation
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The new value, TABLE_UNDEFINED removes the key
+ */
+static void _concurrent_table_store(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen, size_t value
+) {
+  size_t epoch = _concurrent_table_enter(self);
+  _concurrent_table_update(self, key, keylen, value);
+  _concurrent_table_leave(self, epoch);
+}
+
+void concurrent_table_init(EmeraldsConcurrentTable *self) {
+  EmeraldsConcurrentBuckets *buckets =
+    _concurrent_table_allocate(TABLE_INITIAL_SIZE);
+  atomic_init(&self->buckets, buckets);
+  atomic_init(&self->generations, buckets);
+  atomic_init(&self->size, 0);
+  atomic_init(&self->epoch, 2);
+  atomic_init(&self->operations[0].count, 0);
+  atomic_init(&self->operations[1].count, 0);
+  atomic_init(&self->reclaiming, false);
+}
+
+void concurrent_table_add(
+  EmeraldsConcurrentTable *self, const char *key, size_t value
+) {
+  _concurrent_table_store(self, key, strlen(key), value);
+}
+
+void concurrent_table_add_n(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen, size_t value
+) {
+  _concurrent_table_store(self, key, keylen, value);
+}
+
+size_t concurrent_table_get(EmeraldsConcurrentTable *self, const char *key) {
+  return concurrent_table_get_n(self, key, strlen(key));
+}
+
+size_t concurrent_table_get_n(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen
+) {
+  size_t value;
+  size_t epoch;
+  size_t hash =
+    _concurrent_table_stored_hash(TABLE_HASH_FUNCTION(key, keylen));
+
+  epoch = _concurrent_table_enter(self);
+  value = _concurrent_table_lookup(
+    atomic_load(&self->buckets), hash, key, keylen, TABLE_UNDEFINED
+  );
+  _concurrent_table_leave(self, epoch);
+  return value;
+}
+
+void concurrent_table_remove(EmeraldsConcurrentTable *self, const char *key) {
+  _concurrent_table_store(self, key, strlen(key), TABLE_UNDEFINED);
+}
+
+void concurrent_table_remove_n(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen
+) {
+  _concurrent_table_store(self, key, keylen, TABLE_UNDEFINED);
+}
+
+size_t concurrent_table_size(EmeraldsConcurrentTable *self) {
+  return atomic_load(&self->size);
+}
+
+void concurrent_table_deinit(EmeraldsConcurrentTable *self) {
+  EmeraldsConcurrentBuckets *buckets = atomic_load(&self->generations);
+  while(buckets != NULL) {
+    EmeraldsConcurrentBuckets *next = atomic_load(&buckets->next);
+    _concurrent_table_free(buckets);
+    buckets = next;
+  }
+  atomic_store(&self->generations, NULL);
+  atomic_store(&self->buckets, NULL);
+}
+
+#else
+typedef int _concurrent_table_requires_c11;
+#endif
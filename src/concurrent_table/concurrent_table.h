@@ -0,0 +1,180 @@
+#ifndef __CONCURRENT_TABLE_H_
+#define __CONCURRENT_TABLE_H_
+
+#include "../table/table.h"
+
+/* Built only when compiled as C11 with atomics, the default build is C89 */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+  !defined(__STDC_NO_ATOMICS__)
+  #define CONCURRENT_TABLE_AVAILABLE
+
+  #include <stdatomic.h>
+
+  /** @brief Reserved value marking a slot whose entry moved to a new array */
+  #define CONCURRENT_TABLE_MOVED (TABLE_UNDEFINED + 1)
+
+  /** @brief Number of buckets a thread migrates per claimed resize chunk */
+  #ifndef CONCURRENT_TABLE_TRANSFER_STRIDE
+    #define CONCURRENT_TABLE_TRANSFER_STRIDE (256)
+  #endif
+
+  /** @brief Spins on an unpublished key before yielding to its claimer */
+  #ifndef CONCURRENT_TABLE_SPIN_LIMIT
+    #define CONCURRENT_TABLE_SPIN_LIMIT (64)
+  #endif
+
+/**
+ * @brief A single bucket, claimed by a CAS on its hash and published through
+ * its key, the value is updated with CAS afterwards
+ * @param hash -> 0 when empty, 1 when closed by a resize, else the key hash
+ * @param key -> The key, NULL until the claiming thread publishes it
+ * @param length -> The length of the key, written before the key
+ * @param value -> The value, TABLE_UNDEFINED when removed
+ * @param frozen -> The last value, readable after a resize marked it moved
+ */
+typedef struct EmeraldsConcurrentSlot {
+  _Atomic(size_t) hash;
+  _Atomic(const char *) key;
+  size_t length;
+  _Atomic(size_t) value;
+  _Atomic(size_t) frozen;
+} EmeraldsConcurrentSlot;
+
+/**
+ * @brief One bucket array, a resize chains the next one and every thread that
+ * runs into it helps moving chunks of buckets over
+ * @param slots -> The buckets
+ * @param capacity -> The number of buckets
+ * @param claimed -> The number of buckets holding a key
+ * @param next -> The array a resize moves the entries into
+ * @param transfer_index -> The first bucket not yet claimed by a helper
+ * @param transferred -> The number of buckets already moved
+ * @param retired_epoch -> The epoch in which a newer array replaced this one,
+ * CONCURRENT_TABLE_LIVE until then
+ */
+typedef struct EmeraldsConcurrentBuckets {
+  EmeraldsConcurrentSlot *slots;
+  size_t capacity;
+  atomic_size_t claimed;
+  _Atomic(struct EmeraldsConcurrentBuckets *) next;
+  atomic_size_t transfer_index;
+  atomic_size_t transferred;
+  atomic_size_t retired_epoch;
+} EmeraldsConcurrentBuckets;
+
+  /** @brief Retired epoch of an array that is still published or chained */
+  #define CONCURRENT_TABLE_LIVE ((size_t)-1)
+
+/**
+ * @brief The operations in flight that started in epochs of one parity
+ * @param count -> The number of operations
+ * @param padding -> Keeps both counters on their own cache lines
+ */
+typedef struct EmeraldsConcurrentOperations {
+  atomic_size_t count;
+  char padding[TABLE_CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+} EmeraldsConcurrentOperations;
+
+/**
+ * @brief Table where any number of threads insert, update, remove and look up
+ * concurrently, resizing is shared by all threads that touch the table,
+ * lookups never wait while a writer or resize helper meeting a bucket just
+ * claimed for the same hash waits for its key to be published
+ * @param buckets -> The newest fully populated array
+ * @param generations -> The oldest array not yet freed, the others follow
+ * through `next`
+ * @param size -> The number of elements
+ * @param epoch -> The global epoch, only advanced once no operation of the
+ * epoch before it is still running
+ * @param operations -> The operations in flight, by parity of their epoch
+ * @param reclaiming -> Set while one thread frees retired arrays
+ */
+typedef struct EmeraldsConcurrentTable {
+  _Atomic(EmeraldsConcurrentBuckets *) buckets;
+  _Atomic(EmeraldsConcurrentBuckets *) generations;
+  atomic_size_t size;
+  atomic_size_t epoch;
+  EmeraldsConcurrentOperations operations[2];
+  atomic_bool reclaiming;
+} EmeraldsConcurrentTable;
+
+/**
+ * @brief Initializes the table, not thread safe
+ * @param self -> The table
+ */
+void concurrent_table_init(EmeraldsConcurrentTable *self);
+
+/**
+ * @brief Inserts or updates a key, values must not be TABLE_UNDEFINED or
+ * CONCURRENT_TABLE_MOVED
+ * @param self -> The table
+ * @param key -> The key
+ * @param value -> The value
+ */
+void concurrent_table_add(
+  EmeraldsConcurrentTable *self, const char *key, size_t value
+);
+
+/**
+ * @brief Inserts or updates a key of known length
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The value
+ */
+void concurrent_table_add_n(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen, size_t value
+);
+
+/**
+ * @brief Looks up a key
+ * @param self -> The table
+ * @param key -> The key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t concurrent_table_get(EmeraldsConcurrentTable *self, const char *key);
+
+/**
+ * @brief Looks up a key of known length
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t concurrent_table_get_n(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen
+);
+
+/**
+ * @brief Removes a key
+ * @param self -> The table
+ * @param key -> The key
+ */
+void concurrent_table_remove(EmeraldsConcurrentTable *self, const char *key);
+
+/**
+ * @brief Removes a key of known length
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ */
+void concurrent_table_remove_n(
+  EmeraldsConcurrentTable *self, const char *key, size_t keylen
+);
+
+/**
+ * @brief Returns the number of elements
+ * @param self -> The table
+ * @return size_t -> The number of elements
+ */
+size_t concurrent_table_size(EmeraldsConcurrentTable *self);
+
+/**
+ * @brief Deallocates every array, not thread safe
+ * @param self -> The table
+ */
+void concurrent_table_deinit(EmeraldsConcurrentTable *self);
+
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+#include "frozen_table.h"
+
+/**
+ * @brief The pilot bucket of a hash
+ * @param self -> The frozen table
+ * @param hash -> The hash of the key
+ * @return size_t -> The bucket
+ */
+#define _frozen_table_bucket(self, hash) \
+  FROZEN_TABLE_BUCKET((hash), (self)->bucket_count)
+
+/**
+ * @brief The position of a hash displaced by a pilot
+ * @param self -> The frozen table
+ * @param hash -> The hash of the key
+ * @param pilot -> The pilot of the bucket
+ * @return size_t -> The position, may exceed `size` and need remapping
+ */
+#define _frozen_table_position(self, hash, pilot) \
+  FROZEN_TABLE_POSITION((hash), (pilot), (self)->position_count)
+
+/**
+ * @brief Copies the entries of every generation of a table
+ * @param src -> The hash table
+ * @param entries -> The output vector
+ */
+static void
+_frozen_table_collect(EmeraldsTable *src, EmeraldsFrozenSlot **entries) {
+  size_t i;
+  for(i = 0; i < src->capacity; i++) {
+    if(TABLE_STATE_IS_FILLED(src->states[i])) {
+      EmeraldsFrozenSlot entry;
+      entry.hash   = TABLE_HASH_AT(src, i);
+      entry.key    = TABLE_KEY_AT(src, i);
+      entry.length = TABLE_LENGTH_AT(src, i);
+      entry.value  = TABLE_VALUE_AT(src, i);
+      vector_add(*entries, entry);
+    }
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(src->old != NULL) {
+    _frozen_table_collect(src->old, entries);
+  }
+#endif
+}
+
+/**
+ * @brief Searches a pilot that sends every key of a bucket to a free position
+ * distinct from the positions of the other keys of the bucket
+ * @param self -> The frozen table
+ * @param bucket -> The bucket to place
+ * @param members -> The entry indices of the bucket
+ * @param count -> The number of entries in the bucket
+ * @param entries -> The collected entries
+ * @param taken -> One flag per position
+ * @param positions -> Receives the position of every entry
+ * @return bool -> Whether a pilot was found
+ */
+static bool _frozen_table_place_bucket(
+  EmeraldsFrozenTable *self,
+  size_t bucket,
+  const size_t *members,
+  size_t count,
+  const EmeraldsFrozenSlot *entries,
+  uint8_t *taken,
+  size_t *positions
+) {
+  size_t pilot;
+  size_t i;
+  size_t j;
+
+  for(pilot = 0; pilot < FROZEN_TABLE_MAX_PILOT; pilot++) {
+    for(i = 0; i < count; i++) {
+      size_t position =
+        _frozen_table_position(self, entries[members[i]].hash, pilot);
+      if(taken[position]) {
+        break;
+      }
+      for(j = 0; j < i; j++) {
+        if(positions[members[j]] == position) {
+          break;
+        }
+      }
+      if(j < i) {
+        break;
+      }
+      positions[members[i]] = position;
+    }
+
+    if(i == count) {
+      for(i = 0; i < count; i++) {
+        taken[positions[members[i]]] = 1;
+      }
+      self->pilots[bucket] = (uint32_t)pilot;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool table_freeze(EmeraldsTable *src, EmeraldsFrozenTable *dst) {
+  size_t i;
+  size_t n;
+  size_t free_slot;
+  size_t key_bytes;
+  size_t max_bucket_size      = 0;
+  EmeraldsFrozenSlot *entries = NULL;
+  size_t *bucket_of           = NULL;
+  size_t *bucket_offsets      = NULL;
+  size_t *bucket_members      = NULL;
+  size_t *size_offsets        = NULL;
+  size_t *buckets_by_size     = NULL;
+  size_t *positions           = NULL;
+  uint8_t *taken              = NULL;
+  bool placed                 = true;
+
+  vector_initialize_n(entries, src->size);
+  _frozen_table_collect(src, &entries);
+  n = vector_size(entries);
+
+  dst->size           = n;
+  dst->bucket_count   = n / FROZEN_TABLE_BUCKET_SIZE + 1;
+  dst->position_count = n + n / 99 + 1;
+  dst->slots          = NULL;
+  dst->keys           = NULL;
+  dst->remap          = NULL;
+  vector_initialize_n(dst->pilots, dst->bucket_count);
+
+  /* Group entries by bucket */
+  bucket_of      = (size_t *)malloc((n + 1) * sizeof(size_t));
+  bucket_members = (size_t *)malloc((n + 1) * sizeof(size_t));
+  bucket_offsets = (size_t *)calloc(dst->bucket_count + 1, sizeof(size_t));
+  for(i = 0; i < n; i++) {
+    bucket_of[i] = _frozen_table_bucket(dst, entries[i].hash);
+    bucket_offsets[bucket_of[i] + 1]++;
+  }
+  for(i = 0; i < dst->bucket_count; i++) {
+    size_t bucket_size = bucket_offsets[i + 1];
+    if(bucket_size > max_bucket_size) {
+      max_bucket_size = bucket_size;
+    }
+    bucket_offsets[i + 1] += bucket_offsets[i];
+  }
+  for(i = 0; i < n; i++) {
+    bucket_members[bucket_offsets[bucket_of[i]]++] = i;
+  }
+  for(i = dst->bucket_count; i > 0; i--) {
+    bucket_offsets[i] = bucket_offsets[i - 1];
+  }
+  bucket_offsets[0] = 0;
+
+  /* Largest buckets first, while most positions are still free */
+  size_offsets = (size_t *)calloc(max_bucket_size + 2, sizeof(size_t));
+  buckets_by_size = (size_t *)malloc((dst->bucket_count + 1) * sizeof(size_t));
+  for(i = 0; i < dst->bucket_count; i++) {
+    size_t bucket_size = bucket_offsets[i + 1] - bucket_offsets[i];
+    size_offsets[max_bucket_size - bucket_size + 1]++;
+  }
+  for(i = 0; i <= max_bucket_size; i++) {
+    size_offsets[i + 1] += size_offsets[i];
+  }
+  for(i = 0; i < dst->bucket_count; i++) {
+    size_t bucket_size = bucket_offsets[i + 1] - bucket_offsets[i];
+    buckets_by_size[size_offsets[max_bucket_size - bucket_size]++] = i;
+  }
+
+  positions = (size_t *)malloc((n + 1) * sizeof(size_t));
+  taken     = (uint8_t *)calloc(dst->position_count, sizeof(uint8_t));
+  for(i = 0; i < dst->bucket_count && placed; i++) {
+    size_t bucket = buckets_by_size[i];
+    placed        = _frozen_table_place_bucket(
+      dst,
+      bucket,
+      bucket_members + bucket_offsets[bucket],
+      bucket_offsets[bucket + 1] - bucket_offsets[bucket],
+      entries,
+      taken,
+      positions
+    );
+  }
+
+  if(placed) {
+    /* Positions past `size` are redirected to the holes left below it */
+    vector_initialize_n(dst->slots, n + 1);
+    vector_initialize_n(dst->remap, dst->position_count - n);
+    free_slot = 0;
+    for(i = n; i < dst->position_count; i++) {
+      if(taken[i]) {
+        while(taken[free_slot]) {
+          free_slot++;
+        }
+        dst->remap[i - n] = free_slot++;
+      } else {
+        dst->remap[i - n] = 0;
+      }
+    }
+    for(i = 0; i < n; i++) {
+      size_t position = positions[i];
+      if(position >= n) {
+        position = dst->remap[position - n];
+      }
+      dst->slots[position] = entries[i];
+    }
+
+    /* Keys get copied in slot order, the source may change or go away */
+    key_bytes = 1;
+    for(i = 0; i < n; i++) {
+      key_bytes += dst->slots[i].length + 1;
+    }
+    vector_initialize_n(dst->keys, key_bytes);
+    key_bytes = 0;
+    for(i = 0; i < n; i++) {
+      char *copy = dst->keys + key_bytes;
+      memcpy(copy, dst->slots[i].key, dst->slots[i].length);
+      copy[dst->slots[i].length] = '\0';
+      dst->slots[i].key          = copy;
+      key_bytes += dst->slots[i].length + 1;
+    }
+  } else {
+    frozen_table_deinit(dst);
+  }
+
+  free(taken);
+  free(positions);
+  free(buckets_by_size);
+  free(size_offsets);
+  free(bucket_offsets);
+  free(bucket_members);
+  free(bucket_of);
+  vector_free(entries);
+  return placed;
+}
+
+size_t frozen_table_get(EmeraldsFrozenTable *self, const char *key) {
+  return frozen_table_get_n(self, key, strlen(key));
+}
+
+size_t
+frozen_table_get_n(EmeraldsFrozenTable *self, const char *key, size_t keylen) {
+  EmeraldsTableKey handle = table_key_n(key, keylen);
+  return frozen_table_get_h(self, &handle);
+}
+
+size_t
+frozen_table_get_h(EmeraldsFrozenTable *self, const EmeraldsTableKey *key) {
+  size_t bucket;
+  size_t position;
+  EmeraldsFrozenSlot *slot;
+  if(self->size == 0) {
+    return TABLE_UNDEFINED;
+  }
+
+  bucket   = _frozen_table_bucket(self, key->hash);
+  position = _frozen_table_position(self, key->hash, self->pilots[bucket]);
+  if(position >= self->size) {
+    position = self->remap[position - self->size];
+  }
+
+  slot = &self->slots[position];
+  if(slot->hash == key->hash && slot->length == key->length &&
+     memcmp(slot->key, key->key, key->length) == 0) {
+    return slot->value;
+  } else {
+    return TABLE_UNDEFINED;
+  }
+}
+
+size_t frozen_table_size(EmeraldsFrozenTable *self) { return self->size; }
+
+void frozen_table_deinit(EmeraldsFrozenTable *self) {
+  vector_free(self->slots);
+  vector_free(self->keys);
+  vector_free(self->pilots);
+  vector_free(self->remap);
+  self->size = 0;
+}
@@ -0,0 +1,123 @@
+#ifndef __FROZEN_TABLE_H_
+#define __FROZEN_TABLE_H_
+
+#include "../int_table/int_table.h"
+#include "../table/table.h"
+
+/** @brief Average number of keys per pilot bucket */
+#ifndef FROZEN_TABLE_BUCKET_SIZE
+  #define FROZEN_TABLE_BUCKET_SIZE (4)
+#endif
+
+/** @brief Upper bound of pilots tried per bucket before giving up */
+#ifndef FROZEN_TABLE_MAX_PILOT
+  #define FROZEN_TABLE_MAX_PILOT (1 << 24)
+#endif
+
+/**
+ * @brief The pilot bucket of a hash
+ * @param hash -> The hash of the key
+ * @param bucket_count -> The number of pilot buckets
+ * @return size_t -> The bucket
+ */
+#define FROZEN_TABLE_BUCKET(hash, bucket_count) \
+  ((size_t)(int_table_mix((uint64_t)(hash)) % (bucket_count)))
+
+/**
+ * @brief The position of a hash displaced by a pilot
+ * @param hash -> The hash of the key
+ * @param pilot -> The pilot of the bucket
+ * @param position_count -> The range of positions
+ * @return size_t -> The position, may exceed `size` and need remapping
+ */
+#define FROZEN_TABLE_POSITION(hash, pilot, position_count)             \
+  ((size_t)(int_table_mix(                                             \
+              (uint64_t)(hash) ^ int_table_mix((uint64_t)(pilot) + 1) \
+            ) %                                                        \
+            (position_count)))
+
+/**
+ * @brief A single entry of a frozen table
+ * @param hash -> The hash value of the key
+ * @param key -> The key
+ * @param length -> The length of the key
+ * @param value -> The value
+ */
+typedef struct EmeraldsFrozenSlot {
+  size_t hash;
+  const char *key;
+  size_t length;
+  size_t value;
+} EmeraldsFrozenSlot;
+
+/**
+ * @brief Immutable table indexed by a minimal perfect hash (PTHash style),
+ * every key has exactly one candidate slot out of exactly `size` slots
+ * @param slots -> The entries, one per key
+ * @param keys -> The NUL terminated keys, in slot order
+ * @param pilots -> The displacement chosen for every bucket of keys
+ * @param remap -> Maps positions past `size` back into free slots
+ * @param bucket_count -> The number of pilot buckets
+ * @param position_count -> The range of positions produced by the pilots
+ * @param size -> The number of keys (and slots)
+ */
+typedef struct EmeraldsFrozenTable {
+  EmeraldsFrozenSlot *slots;
+  char *keys;
+  uint32_t *pilots;
+  size_t *remap;
+  size_t bucket_count;
+  size_t position_count;
+  size_t size;
+} EmeraldsFrozenTable;
+
+/**
+ * @brief Builds an immutable copy of a populated table, keys are copied into
+ * one contiguous block so `src` may change or be deinitialized afterwards
+ * @param src -> The populated hash table
+ * @param dst -> The frozen table to initialize
+ * @return bool -> false if no perfect hash was found (colliding hashes)
+ */
+bool table_freeze(EmeraldsTable *src, EmeraldsFrozenTable *dst);
+
+/**
+ * @brief Single probe lookup
+ * @param self -> The frozen table
+ * @param key -> The key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t frozen_table_get(EmeraldsFrozenTable *self, const char *key);
+
+/**
+ * @brief Single probe lookup of a key of known length
+ * @param self -> The frozen table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t
+frozen_table_get_n(EmeraldsFrozenTable *self, const char *key, size_t keylen);
+
+/**
+ * @brief Single probe lookup of a precomputed key handle
+ * @param self -> The frozen table
+ * @param key -> The key handle
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t
+frozen_table_get_h(EmeraldsFrozenTable *self, const EmeraldsTableKey *key);
+
+/**
+ * @brief Returns the number of keys of the frozen table
+ * @param self -> The frozen table
+ * @return size_t -> The number of keys
+ */
+size_t frozen_table_size(EmeraldsFrozenTable *self);
+
+/**
+ * @brief Deallocates all vectors of the frozen table
+ * @param self -> The frozen table
+ */
+void frozen_table_deinit(EmeraldsFrozenTable *self);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef __INT_TABLE_H_
+#define __INT_TABLE_H_
+
+#include "../typed_table/typed_table.h"
+
+/**
+ * @brief Bijective multiply-xorshift mixer, spreads high bits into the low
+ * bits used for the home bucket so sequential ids do not cluster
+ * @param key -> The integer key
+ * @return size_t -> The mixed hash
+ */
+p_inline size_t int_table_mix(uint64_t key) {
+  key ^= key >> 32;
+  key *= (uint64_t)0xd6e8feb86659fd93;
+  key ^= key >> 32;
+  key *= (uint64_t)0xd6e8feb86659fd93;
+  key ^= key >> 32;
+  return (size_t)key;
+}
+
+/**
+ * @brief Mixes the address of a pointer key
+ * @param key -> The pointer key
+ * @return size_t -> The mixed hash
+ */
+p_inline size_t pointer_table_mix(const void *key) {
+  return int_table_mix((uint64_t)(size_t)key);
+}
+
+#define _int_table_equals(a, b) ((a) == (b))
+
+/**
+ * @brief Integer keyed table, e.g object id -> slot
+ * Generates int_table_init/add/get/remove/size/deinit
+ */
+TABLE_DEFINE(
+  EmeraldsIntTable,
+  int_table,
+  uint64_t,
+  size_t,
+  int_table_mix,
+  _int_table_equals
+);
+
+/**
+ * @brief Pointer keyed table, e.g object -> metadata
+ * Generates pointer_table_init/add/get/remove/size/deinit
+ */
+TABLE_DEFINE(
+  EmeraldsPointerTable,
+  pointer_table,
+  const void *,
+  size_t,
+  pointer_table_mix,
+  _int_table_equals
+);
+
+#endif
@@ -0,0 +1,319 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "mapped_table.h"
+
+#include <stdio.h>
+
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+/**
+ * @brief Rounds an offset up to the next multiple of 8
+ * @param offset -> The offset
+ * @return uint64_t -> The aligned offset
+ */
+#define _mapped_table_align(offset) (((offset) + 7) & ~(uint64_t)7)
+
+/**
+ * @brief The hash of the magic under the configured TABLE_HASH_FUNCTION
+ * @return uint64_t -> The value stored as `hash_check`
+ */
+#define _mapped_table_hash_check()                     \
+  ((uint64_t)TABLE_HASH_FUNCTION(                      \
+    MAPPED_TABLE_MAGIC, sizeof(MAPPED_TABLE_MAGIC) - 1 \
+  ))
+
+/**
+ * @brief Writes zero bytes up to an aligned offset
+ * @param file -> The file
+ * @param from -> The current offset
+ * @param to -> The aligned offset
+ */
+static void _mapped_table_pad(FILE *file, uint64_t from, uint64_t to) {
+  for(; from < to; from++) {
+    fputc(0, file);
+  }
+}
+
+bool table_save(EmeraldsTable *self, const char *path) {
+  size_t i;
+  bool saved;
+  uint64_t key_offset;
+  EmeraldsMappedHeader header;
+  EmeraldsFrozenTable frozen;
+  FILE *file;
+
+  if(!table_freeze(self, &frozen)) {
+    return false;
+  }
+
+  file = fopen(path, "wb");
+  if(file == NULL) {
+    frozen_table_deinit(&frozen);
+    return false;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAPPED_TABLE_MAGIC, sizeof(MAPPED_TABLE_MAGIC));
+  header.version        = MAPPED_TABLE_VERSION;
+  header.word_size      = sizeof(size_t);
+  header.hash_check     = _mapped_table_hash_check();
+  header.size           = frozen.size;
+  header.bucket_count   = frozen.bucket_count;
+  header.position_count = frozen.position_count;
+  header.slots_offset   = _mapped_table_align(sizeof(header));
+  header.pilots_offset =
+    header.slots_offset + header.size * sizeof(EmeraldsMappedSlot);
+  header.remap_offset = _mapped_table_align(
+    header.pilots_offset + header.bucket_count * sizeof(uint32_t)
+  );
+  header.keys_offset =
+    header.remap_offset +
+    (header.position_count - header.size) * sizeof(uint64_t);
+  header.file_size = header.keys_offset;
+  for(i = 0; i < frozen.size; i++) {
+    header.file_size += frozen.slots[i].length;
+  }
+
+  fwrite(&header, sizeof(header), 1, file);
+  _mapped_table_pad(file, sizeof(header), header.slots_offset);
+
+  key_offset = 0;
+  for(i = 0; i < frozen.size; i++) {
+    EmeraldsMappedSlot slot;
+    slot.hash   = frozen.slots[i].hash;
+    slot.key    = key_offset;
+    slot.length = frozen.slots[i].length;
+    slot.value  = frozen.slots[i].value;
+    fwrite(&slot, sizeof(slot), 1, file);
+    key_offset += slot.length;
+  }
+
+  fwrite(frozen.pilots, sizeof(uint32_t), frozen.bucket_count, file);
+  _mapped_table_pad(
+    file,
+    header.pilots_offset + header.bucket_count * sizeof(uint32_t),
+    header.remap_offset
+  );
+
+  for(i = 0; i < frozen.position_count - frozen.size; i++) {
+    uint64_t remap = frozen.remap[i];
+    fwrite(&remap, sizeof(remap), 1, file);
+  }
+
+  for(i = 0; i < frozen.size; i++) {
+    fwrite(frozen.slots[i].key, 1, frozen.slots[i].length, file);
+  }
+
+  saved = !ferror(file);
+  saved = fclose(file) == 0 && saved;
+  frozen_table_deinit(&frozen);
+  return saved;
+}
+
+/**
+ * @brief Computes the end of a section without wrapping around
+ * @param offset -> Where the section starts
+ * @param count -> The number of elements
+ * @param width -> The size of an element
+ * @param end -> Receives the end of the section
+ * @return bool -> false if the end does not fit in 64 bits
+ */
+static bool _mapped_table_section_end(
+  uint64_t offset, uint64_t count, uint64_t width, uint64_t *end
+) {
+  if(count > (~(uint64_t)0 - offset) / width) {
+    return false;
+  }
+  *end = offset + count * width;
+  return true;
+}
+
+/**
+ * @brief Checks that a mapped header describes a well formed file
+ * @param header -> The header at the start of the mapping
+ * @param mapping_size -> The length of the mapping
+ * @return bool -> Whether every section is aligned and lies inside the mapping
+ */
+static bool _mapped_table_header_is_valid(
+  const EmeraldsMappedHeader *header, size_t mapping_size
+) {
+  uint64_t slots_end;
+  uint64_t pilots_end;
+  uint64_t remap_end;
+
+  if(memcmp(header->magic, MAPPED_TABLE_MAGIC, sizeof(MAPPED_TABLE_MAGIC)) ||
+     header->version != MAPPED_TABLE_VERSION ||
+     header->word_size != sizeof(size_t) ||
+     header->hash_check != _mapped_table_hash_check() ||
+     header->file_size != mapping_size || header->bucket_count == 0 ||
+     header->position_count <= header->size) {
+    return false;
+  }
+
+  if(header->slots_offset % sizeof(uint64_t) != 0 ||
+     header->pilots_offset % sizeof(uint32_t) != 0 ||
+     header->remap_offset % sizeof(uint64_t) != 0) {
+    return false;
+  }
+
+  if(!_mapped_table_section_end(
+       header->slots_offset,
+       header->size,
+       sizeof(EmeraldsMappedSlot),
+       &slots_end
+     ) ||
+     !_mapped_table_section_end(
+       header->pilots_offset,
+       header->bucket_count,
+       sizeof(uint32_t),
+       &pilots_end
+     ) ||
+     !_mapped_table_section_end(
+       header->remap_offset,
+       header->position_count - header->size,
+       sizeof(uint64_t),
+       &remap_end
+     )) {
+    return false;
+  }
+
+  return header->slots_offset >= sizeof(*header) &&
+         header->pilots_offset == slots_end &&
+         header->remap_offset >= pilots_end &&
+         header->keys_offset == remap_end &&
+         header->keys_offset <= header->file_size;
+}
+
+/**
+ * @brief Checks that every slot points inside the key blob and every remap
+ * entry at a slot, called once the sections are known to be in bounds
+ * @param self -> The mapped table
+ * @param keys_size -> The length of the key blob
+ * @return bool -> Whether lookups can follow every offset of the file
+ */
+static bool
+_mapped_table_entries_are_valid(EmeraldsMappedTable *self, uint64_t keys_size) {
+  size_t i;
+
+  for(i = 0; i < self->size; i++) {
+    if(self->slots[i].key > keys_size ||
+       self->slots[i].length > keys_size - self->slots[i].key) {
+      return false;
+    }
+  }
+  /* Unused remap entries of an empty table are never read */
+  for(i = 0; i < self->position_count - self->size && self->size > 0; i++) {
+    if(self->remap[i] >= self->size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool table_map(EmeraldsMappedTable *self, const char *path) {
+#if defined(_WIN32)
+  (void)path;
+  memset(self, 0, sizeof(*self));
+  return false;
+#else
+  int fd;
+  struct stat info;
+  void *mapping;
+  const EmeraldsMappedHeader *header;
+
+  memset(self, 0, sizeof(*self));
+  fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+  if(fstat(fd, &info) != 0 ||
+     (size_t)info.st_size < sizeof(EmeraldsMappedHeader)) {
+    close(fd);
+    return false;
+  }
+
+  mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(mapping == MAP_FAILED) {
+    return false;
+  }
+
+  header = (const EmeraldsMappedHeader *)mapping;
+  if(!_mapped_table_header_is_valid(header, (size_t)info.st_size)) {
+    munmap(mapping, (size_t)info.st_size);
+    return false;
+  }
+
+  self->mapping      = mapping;
+  self->mapping_size = (size_t)info.st_size;
+  self->slots =
+    (const EmeraldsMappedSlot *)((char *)mapping + header->slots_offset);
+  self->pilots = (const uint32_t *)((char *)mapping + header->pilots_offset);
+  self->remap  = (const uint64_t *)((char *)mapping + header->remap_offset);
+  self->keys   = (const char *)mapping + header->keys_offset;
+  self->bucket_count   = (size_t)header->bucket_count;
+  self->position_count = (size_t)header->position_count;
+  self->size           = (size_t)header->size;
+  if(!_mapped_table_entries_are_valid(
+       self, header->file_size - header->keys_offset
+     )) {
+    mapped_table_unmap(self);
+    return false;
+  }
+  return true;
+#endif
+}
+
+size_t mapped_table_get(EmeraldsMappedTable *self, const char *key) {
+  return mapped_table_get_n(self, key, strlen(key));
+}
+
+size_t
+mapped_table_get_n(EmeraldsMappedTable *self, const char *key, size_t keylen) {
+  EmeraldsTableKey handle = table_key_n(key, keylen);
+  return mapped_table_get_h(self, &handle);
+}
+
+size_t
+mapped_table_get_h(EmeraldsMappedTable *self, const EmeraldsTableKey *key) {
+  size_t bucket;
+  size_t position;
+  const EmeraldsMappedSlot *slot;
+  if(self->size == 0) {
+    return TABLE_UNDEFINED;
+  }
+
+  bucket   = FROZEN_TABLE_BUCKET(key->hash, self->bucket_count);
+  position = FROZEN_TABLE_POSITION(
+    key->hash, self->pilots[bucket], self->position_count
+  );
+  if(position >= self->size) {
+    position = (size_t)self->remap[position - self->size];
+  }
+
+  slot = &self->slots[position];
+  if((size_t)slot->hash == key->hash && slot->length == key->length &&
+     memcmp(self->keys + slot->key, key->key, key->length) == 0) {
+    return (size_t)slot->value;
+  } else {
+    return TABLE_UNDEFINED;
+  }
+}
+
+size_t mapped_table_size(EmeraldsMappedTable *self) { return self->size; }
+
+void mapped_table_unmap(EmeraldsMappedTable *self) {
+#if !defined(_WIN32)
+  if(self->mapping != NULL) {
+    munmap(self->mapping, self->mapping_size);
+  }
+#endif
+  memset(self, 0, sizeof(*self));
+}
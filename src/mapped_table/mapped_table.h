@@ -0,0 +1,137 @@
+#ifndef __MAPPED_TABLE_H_
+#define __MAPPED_TABLE_H_
+
+#include "../frozen_table/frozen_table.h"
+
+#define MAPPED_TABLE_MAGIC   "EMTABLE"
+#define MAPPED_TABLE_VERSION (2)
+
+/**
+ * @brief File header, every offset is relative to the start of the file
+ * @param magic -> MAPPED_TABLE_MAGIC
+ * @param version -> MAPPED_TABLE_VERSION
+ * @param word_size -> sizeof(size_t) of the writer, hashes depend on it
+ * @param hash_check -> TABLE_HASH_FUNCTION of the magic, files hashed by a
+ * different function are refused
+ * @param size -> The number of keys (and slots)
+ * @param bucket_count -> The number of pilot buckets
+ * @param position_count -> The range of positions produced by the pilots
+ * @param slots_offset -> Where the EmeraldsMappedSlot array starts
+ * @param pilots_offset -> Where the uint32_t pilot array starts
+ * @param remap_offset -> Where the uint64_t remap array starts
+ * @param keys_offset -> Where the key blob starts
+ * @param file_size -> The total size of the file
+ */
+typedef struct EmeraldsMappedHeader {
+  char magic[8];
+  uint64_t version;
+  uint64_t word_size;
+  uint64_t hash_check;
+  uint64_t size;
+  uint64_t bucket_count;
+  uint64_t position_count;
+  uint64_t slots_offset;
+  uint64_t pilots_offset;
+  uint64_t remap_offset;
+  uint64_t keys_offset;
+  uint64_t file_size;
+} EmeraldsMappedHeader;
+
+/**
+ * @brief A single entry of a mapped table
+ * @param hash -> The hash value of the key
+ * @param key -> The offset of the key inside the key blob
+ * @param length -> The length of the key
+ * @param value -> The value
+ */
+typedef struct EmeraldsMappedSlot {
+  uint64_t hash;
+  uint64_t key;
+  uint64_t length;
+  uint64_t value;
+} EmeraldsMappedSlot;
+
+/**
+ * @brief Read-only view of a table file, lookups read the mapping directly
+ * @param mapping -> The start of the mapped file
+ * @param mapping_size -> The length of the mapping
+ * @param slots -> The entries, one per key
+ * @param pilots -> The displacement chosen for every bucket of keys
+ * @param remap -> Maps positions past `size` back into free slots
+ * @param keys -> The key blob
+ * @param bucket_count -> The number of pilot buckets
+ * @param position_count -> The range of positions produced by the pilots
+ * @param size -> The number of keys (and slots)
+ */
+typedef struct EmeraldsMappedTable {
+  void *mapping;
+  size_t mapping_size;
+  const EmeraldsMappedSlot *slots;
+  const uint32_t *pilots;
+  const uint64_t *remap;
+  const char *keys;
+  size_t bucket_count;
+  size_t position_count;
+  size_t size;
+} EmeraldsMappedTable;
+
+/**
+ * @brief Writes a table to a file in the frozen table format with keys
+ * serialized as offsets into a trailing blob
+ * @param self -> The hash table
+ * @param path -> The file to create or truncate
+ * @return bool -> false if the table could not be frozen or written
+ */
+bool table_save(EmeraldsTable *self, const char *path);
+
+/**
+ * @brief Maps a file written by `table_save` without deserializing it, every
+ * section, slot and remap entry is bounds checked once here so lookups can
+ * trust the mapping
+ * @param self -> The mapped table to initialize
+ * @param path -> The file to map
+ * @return bool -> false if the file is missing, malformed or foreign
+ */
+bool table_map(EmeraldsMappedTable *self, const char *path);
+
+/**
+ * @brief Single probe lookup
+ * @param self -> The mapped table
+ * @param key -> The key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t mapped_table_get(EmeraldsMappedTable *self, const char *key);
+
+/**
+ * @brief Single probe lookup of a key of known length
+ * @param self -> The mapped table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t
+mapped_table_get_n(EmeraldsMappedTable *self, const char *key, size_t keylen);
+
+/**
+ * @brief Single probe lookup of a precomputed key handle
+ * @param self -> The mapped table
+ * @param key -> The key handle
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t
+mapped_table_get_h(EmeraldsMappedTable *self, const EmeraldsTableKey *key);
+
+/**
+ * @brief Returns the number of keys of the mapped table
+ * @param self -> The mapped table
+ * @return size_t -> The number of keys
+ */
+size_t mapped_table_size(EmeraldsMappedTable *self);
+
+/**
+ * @brief Unmaps the file
+ * @param self -> The mapped table
+ */
+void mapped_table_unmap(EmeraldsMappedTable *self);
+
+#endif
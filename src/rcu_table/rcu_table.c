@@ -0,0 +1,283 @@
+#include "rcu_table.h"
+
+#if defined(__ATOMIC_SEQ_CST)
+
+/**
+ * @brief Allocates an empty generation, header, slots and states in one block
+ * @param capacity -> The bucket count, a power of two
+ * @return EmeraldsRcuBuckets * -> The generation
+ */
+p_inline EmeraldsRcuBuckets *_rcu_table_allocate(size_t capacity) {
+  EmeraldsRcuBuckets *buckets = (EmeraldsRcuBuckets *)malloc(
+    sizeof(EmeraldsRcuBuckets) + capacity * sizeof(EmeraldsRcuSlot) + capacity
+  );
+  buckets->slots         = (EmeraldsRcuSlot *)(buckets + 1);
+  buckets->states        = (uint8_t *)(buckets->slots + capacity);
+  buckets->capacity      = capacity;
+  buckets->retired_epoch = 0;
+  buckets->next          = NULL;
+  memset(buckets->states, TABLE_STATE_EMPTY, capacity);
+  return buckets;
+}
+
+/**
+ * @brief Reader side probe, only filled buckets are compared
+ * @param buckets -> The generation
+ * @param hash -> The hash of the key
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> The index of the bucket or TABLE_UNDEFINED if not found
+ */
+p_inline size_t _rcu_table_find(
+  EmeraldsRcuBuckets *buckets, size_t hash, const char *key, size_t keylen
+) {
+  size_t mask         = buckets->capacity - 1;
+  size_t bucket_index = hash & mask;
+
+  while(true) {
+    uint8_t state =
+      __atomic_load_n(&buckets->states[bucket_index], __ATOMIC_ACQUIRE);
+    if(state == TABLE_STATE_EMPTY) {
+      return TABLE_UNDEFINED;
+    } else if(state == TABLE_STATE_FILLED) {
+      EmeraldsRcuSlot *slot = &buckets->slots[bucket_index];
+      if(slot->hash == hash && slot->length == keylen &&
+         memcmp(slot->key, key, keylen) == 0) {
+        return bucket_index;
+      }
+    }
+    bucket_index = (bucket_index + 1) & mask;
+  }
+}
+
+/**
+ * @brief Writer side probe, a key keeps its bucket for the whole lifetime of a
+ * generation so deleted buckets match too and are never handed to other keys
+ * @param buckets -> The generation
+ * @param hash -> The hash of the key
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> The bucket of the key or the empty bucket ending the probe
+ */
+p_inline size_t _rcu_table_find_slot(
+  EmeraldsRcuBuckets *buckets, size_t hash, const char *key, size_t keylen
+) {
+  size_t mask         = buckets->capacity - 1;
+  size_t bucket_index = hash & mask;
+
+  while(buckets->states[bucket_index] != TABLE_STATE_EMPTY) {
+    EmeraldsRcuSlot *slot = &buckets->slots[bucket_index];
+    if(slot->hash == hash && slot->length == keylen &&
+       memcmp(slot->key, key, keylen) == 0) {
+      break;
+    }
+    bucket_index = (bucket_index + 1) & mask;
+  }
+  return bucket_index;
+}
+
+size_t rcu_table_reclaim(EmeraldsRcuTable *self) {
+  size_t i;
+  size_t waiting = 0;
+  size_t oldest  = (size_t)-1;
+  EmeraldsRcuBuckets **link = &self->retired;
+
+  /* Free slots announce 0 like readers outside of a section */
+  for(i = 0; i < RCU_TABLE_MAX_READERS; i++) {
+    size_t epoch =
+      __atomic_load_n(&self->readers[i].epoch, __ATOMIC_SEQ_CST);
+    if(epoch != 0 && epoch < oldest) {
+      oldest = epoch;
+    }
+  }
+
+  /* A reader that entered after a generation got retired cannot see it */
+  while(*link != NULL) {
+    EmeraldsRcuBuckets *buckets = *link;
+    if(buckets->retired_epoch < oldest) {
+      *link = buckets->next;
+      free(buckets);
+    } else {
+      link = &buckets->next;
+      waiting++;
+    }
+  }
+  return waiting;
+}
+
+/**
+ * @brief Copies the live entries into a fresh generation sized for them,
+ * publishes it and retires the current one
+ * @param self -> The table
+ */
+p_inline void _rcu_table_resize(EmeraldsRcuTable *self) {
+  size_t i;
+  EmeraldsRcuBuckets *old = self->buckets;
+  EmeraldsRcuBuckets *buckets;
+  size_t capacity = TABLE_INITIAL_SIZE;
+
+  while(self->size + 1 > capacity * TABLE_LOAD_FACTOR) {
+    capacity *= 2;
+  }
+  buckets = _rcu_table_allocate(capacity);
+  for(i = 0; i < old->capacity; i++) {
+    if(old->states[i] == TABLE_STATE_FILLED) {
+      size_t bucket_index = old->slots[i].hash & (capacity - 1);
+      while(buckets->states[bucket_index] != TABLE_STATE_EMPTY) {
+        bucket_index = (bucket_index + 1) & (capacity - 1);
+      }
+      buckets->slots[bucket_index]  = old->slots[i];
+      buckets->states[bucket_index] = TABLE_STATE_FILLED;
+    }
+  }
+  self->tombstones = 0;
+
+  __atomic_store_n(&self->buckets, buckets, __ATOMIC_SEQ_CST);
+  old->retired_epoch = self->epoch;
+  old->next          = self->retired;
+  self->retired      = old;
+  __atomic_fetch_add(&self->epoch, 1, __ATOMIC_SEQ_CST);
+  rcu_table_reclaim(self);
+}
+
+void rcu_table_init(EmeraldsRcuTable *self) {
+  self->buckets = _rcu_table_allocate(TABLE_INITIAL_SIZE);
+  self->retired = NULL;
+  self->epoch   = 1;
+  memset(self->readers, 0, sizeof(self->readers));
+  self->size       = 0;
+  self->tombstones = 0;
+}
+
+size_t rcu_table_register(EmeraldsRcuTable *self) {
+  size_t reader;
+  for(reader = 0; reader < RCU_TABLE_MAX_READERS; reader++) {
+    size_t expected = 0;
+    if(__atomic_compare_exchange_n(
+         &self->readers[reader].in_use,
+         &expected,
+         1,
+         false,
+         __ATOMIC_ACQUIRE,
+         __ATOMIC_RELAXED
+       )) {
+      return reader;
+    }
+  }
+  return TABLE_UNDEFINED;
+}
+
+void rcu_table_unregister(EmeraldsRcuTable *self, size_t reader) {
+  __atomic_store_n(&self->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&self->readers[reader].in_use, 0, __ATOMIC_RELEASE);
+}
+
+void rcu_table_enter(EmeraldsRcuTable *self, size_t reader) {
+  __atomic_store_n(
+    &self->readers[reader].epoch,
+    __atomic_load_n(&self->epoch, __ATOMIC_SEQ_CST),
+    __ATOMIC_SEQ_CST
+  );
+}
+
+void rcu_table_leave(EmeraldsRcuTable *self, size_t reader) {
+  __atomic_store_n(&self->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+size_t rcu_table_get(EmeraldsRcuTable *self, const char *key) {
+  return rcu_table_get_n(self, key, strlen(key));
+}
+
+size_t rcu_table_get_n(EmeraldsRcuTable *self, const char *key, size_t keylen) {
+  EmeraldsRcuBuckets *buckets =
+    __atomic_load_n(&self->buckets, __ATOMIC_SEQ_CST);
+  size_t bucket_index = _rcu_table_find(
+    buckets, TABLE_HASH_FUNCTION(key, keylen), key, keylen
+  );
+
+  if(bucket_index != TABLE_UNDEFINED) {
+    return __atomic_load_n(
+      &buckets->slots[bucket_index].value, __ATOMIC_RELAXED
+    );
+  } else {
+    return TABLE_UNDEFINED;
+  }
+}
+
+void rcu_table_add(EmeraldsRcuTable *self, const char *key, size_t value) {
+  rcu_table_add_n(self, key, strlen(key), value);
+}
+
+void rcu_table_add_n(
+  EmeraldsRcuTable *self, const char *key, size_t keylen, size_t value
+) {
+  size_t bucket_index;
+  size_t hash = TABLE_HASH_FUNCTION(key, keylen);
+  EmeraldsRcuBuckets *buckets;
+
+  if(self->size + self->tombstones + 1 >
+     self->buckets->capacity * TABLE_LOAD_FACTOR) {
+    _rcu_table_resize(self);
+  }
+
+  buckets      = self->buckets;
+  bucket_index = _rcu_table_find_slot(buckets, hash, key, keylen);
+  __atomic_store_n(
+    &buckets->slots[bucket_index].value, value, __ATOMIC_RELAXED
+  );
+
+  switch(buckets->states[bucket_index]) {
+  case TABLE_STATE_EMPTY:
+    buckets->slots[bucket_index].hash   = hash;
+    buckets->slots[bucket_index].key    = key;
+    buckets->slots[bucket_index].length = keylen;
+    self->size++;
+    break;
+  case TABLE_STATE_DELETED:
+    self->size++;
+    self->tombstones--;
+    break;
+  default:
+    return;
+  }
+
+  /* Publishes the fields above to readers that observe the filled state */
+  __atomic_store_n(
+    &buckets->states[bucket_index], TABLE_STATE_FILLED, __ATOMIC_RELEASE
+  );
+}
+
+void rcu_table_remove(EmeraldsRcuTable *self, const char *key) {
+  rcu_table_remove_n(self, key, strlen(key));
+}
+
+void rcu_table_remove_n(
+  EmeraldsRcuTable *self, const char *key, size_t keylen
+) {
+  EmeraldsRcuBuckets *buckets = self->buckets;
+  size_t bucket_index         = _rcu_table_find_slot(
+    buckets, TABLE_HASH_FUNCTION(key, keylen), key, keylen
+  );
+
+  if(buckets->states[bucket_index] == TABLE_STATE_FILLED) {
+    __atomic_store_n(
+      &buckets->states[bucket_index], TABLE_STATE_DELETED, __ATOMIC_RELEASE
+    );
+    self->size--;
+    self->tombstones++;
+  }
+}
+
+size_t rcu_table_size(EmeraldsRcuTable *self) { return self->size; }
+
+void rcu_table_deinit(EmeraldsRcuTable *self) {
+  while(self->retired != NULL) {
+    EmeraldsRcuBuckets *next = self->retired->next;
+    free(self->retired);
+    self->retired = next;
+  }
+  free(self->buckets);
+  self->buckets = NULL;
+}
+
+#endif
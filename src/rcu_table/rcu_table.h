@@ -0,0 +1,184 @@
+#ifndef __RCU_TABLE_H_
+#define __RCU_TABLE_H_
+
+#include "../table/table.h"
+
+/* Needs the GCC/Clang __atomic builtins, available in -std=c89 as well */
+#if defined(__ATOMIC_SEQ_CST)
+
+  /** @brief Number of reader threads that can be registered at once */
+  #ifndef RCU_TABLE_MAX_READERS
+    #define RCU_TABLE_MAX_READERS (64)
+  #endif
+
+/**
+ * @brief A single bucket, fields are written once before the state publishes
+ * them, afterwards only the value and the state ever change
+ * @param hash -> The hash value of the key
+ * @param key -> The key
+ * @param length -> The length of the key
+ * @param value -> The value, accessed atomically
+ */
+typedef struct EmeraldsRcuSlot {
+  size_t hash;
+  const char *key;
+  size_t length;
+  size_t value;
+} EmeraldsRcuSlot;
+
+/**
+ * @brief One published generation of buckets, replaced as a whole on resize
+ * @param states -> The state of each bucket (empty, deleted or filled)
+ * @param slots -> The buckets
+ * @param capacity -> The number of buckets
+ * @param retired_epoch -> The epoch in which the generation got replaced
+ * @param next -> The next retired generation
+ */
+typedef struct EmeraldsRcuBuckets {
+  uint8_t *states;
+  EmeraldsRcuSlot *slots;
+  size_t capacity;
+  size_t retired_epoch;
+  struct EmeraldsRcuBuckets *next;
+} EmeraldsRcuBuckets;
+
+/**
+ * @brief The epoch a reader entered in, 0 while outside of a read section
+ * @param epoch -> The announced epoch
+ * @param in_use -> Whether a registered thread owns the slot
+ * @param padding -> Keeps every reader on its own cache line
+ */
+typedef struct EmeraldsRcuReader {
+  size_t epoch;
+  size_t in_use;
+  char padding[TABLE_CACHE_LINE_SIZE - 2 * sizeof(size_t)];
+} EmeraldsRcuReader;
+
+/**
+ * @brief Table with lock-free readers and a single writer, readers never wait
+ * and retired bucket generations are freed once no reader can still see them
+ * @param buckets -> The published generation
+ * @param retired -> Replaced generations waiting for their readers to leave
+ * @param epoch -> The global epoch, advanced on every resize
+ * @param readers -> The epoch announced by every registered reader
+ * @param size -> The number of elements (writer only)
+ * @param tombstones -> The number of deleted buckets (writer only)
+ */
+typedef struct EmeraldsRcuTable {
+  EmeraldsRcuBuckets *buckets;
+  EmeraldsRcuBuckets *retired;
+  size_t epoch;
+  EmeraldsRcuReader readers[RCU_TABLE_MAX_READERS];
+  size_t size;
+  size_t tombstones;
+} EmeraldsRcuTable;
+
+/**
+ * @brief Initializes the table, not thread safe
+ * @param self -> The table
+ */
+void rcu_table_init(EmeraldsRcuTable *self);
+
+/**
+ * @brief Registers a reader thread by claiming a free slot, thread safe
+ * @param self -> The table
+ * @return size_t -> The reader id or TABLE_UNDEFINED if all slots are taken
+ */
+size_t rcu_table_register(EmeraldsRcuTable *self);
+
+/**
+ * @brief Gives the slot of a reader back for later registrations, called
+ * outside of a read section by the thread that registered it
+ * @param self -> The table
+ * @param reader -> The reader id
+ */
+void rcu_table_unregister(EmeraldsRcuTable *self, size_t reader);
+
+/**
+ * @brief Starts a read section, lookups are only valid inside one
+ * @param self -> The table
+ * @param reader -> The reader id
+ */
+void rcu_table_enter(EmeraldsRcuTable *self, size_t reader);
+
+/**
+ * @brief Ends a read section, buckets seen inside it may be freed afterwards
+ * @param self -> The table
+ * @param reader -> The reader id
+ */
+void rcu_table_leave(EmeraldsRcuTable *self, size_t reader);
+
+/**
+ * @brief Lock-free lookup, called inside a read section or by the writer
+ * @param self -> The table
+ * @param key -> The key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t rcu_table_get(EmeraldsRcuTable *self, const char *key);
+
+/**
+ * @brief Lock-free lookup of a key of known length
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t rcu_table_get_n(EmeraldsRcuTable *self, const char *key, size_t keylen);
+
+/**
+ * @brief Inserts or updates a key, writer only
+ * @param self -> The table
+ * @param key -> The key
+ * @param value -> The value
+ */
+void rcu_table_add(EmeraldsRcuTable *self, const char *key, size_t value);
+
+/**
+ * @brief Inserts or updates a key of known length, writer only
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The value
+ */
+void rcu_table_add_n(
+  EmeraldsRcuTable *self, const char *key, size_t keylen, size_t value
+);
+
+/**
+ * @brief Removes a key, writer only
+ * @param self -> The table
+ * @param key -> The key
+ */
+void rcu_table_remove(EmeraldsRcuTable *self, const char *key);
+
+/**
+ * @brief Removes a key of known length, writer only
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ */
+void rcu_table_remove_n(EmeraldsRcuTable *self, const char *key, size_t keylen);
+
+/**
+ * @brief Frees the retired generations no reader can see anymore, writer only
+ * @param self -> The table
+ * @return size_t -> The number of generations still waiting
+ */
+size_t rcu_table_reclaim(EmeraldsRcuTable *self);
+
+/**
+ * @brief Returns the number of elements, writer only
+ * @param self -> The table
+ * @return size_t -> The number of elements
+ */
+size_t rcu_table_size(EmeraldsRcuTable *self);
+
+/**
+ * @brief Deallocates every generation, no reader may be inside a section
+ * @param self -> The table
+ */
+void rcu_table_deinit(EmeraldsRcuTable *self);
+
+#endif
+
+#endif
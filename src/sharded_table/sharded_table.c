@@ -0,0 +1,368 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "sharded_table.h"
+
+#if defined(SHARDED_TABLE_AVAILABLE)
+
+  #if defined(SHARDED_TABLE_SPINLOCK)
+    #define _sharded_table_lock_init(lock) (*(lock) = 0)
+    #define _sharded_table_lock_destroy(lock)
+    #define _sharded_table_unlock(lock) \
+      __atomic_store_n((lock), 0, __ATOMIC_RELEASE)
+
+/**
+ * @brief Test and test-and-set, waiting threads only read the shared line
+ * @param lock -> The lock
+ */
+p_inline void _sharded_table_lock(EmeraldsShardedLock *lock) {
+  while(__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+    while(__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+    }
+  }
+}
+  #else
+    #define _sharded_table_lock_init(lock)    pthread_mutex_init((lock), NULL)
+    #define _sharded_table_lock_destroy(lock) pthread_mutex_destroy(lock)
+    #define _sharded_table_lock(lock)         pthread_mutex_lock(lock)
+    #define _sharded_table_unlock(lock)       pthread_mutex_unlock(lock)
+  #endif
+
+/**
+ * @brief The share of a parallel bulk operation handled by one worker, worker
+ * `w` owns shards w, w + workers, w + 2 * workers and so on
+ * @param self -> The table
+ * @param worker -> The worker index
+ * @param workers -> The number of workers
+ * @param keys -> The keys being loaded
+ * @param values -> The values being loaded
+ * @param n -> The number of pairs being loaded
+ * @param handles -> The hashed keys
+ * @param order -> The pair indices grouped by shard
+ * @param starts -> The first entry of every shard in `order`
+ * @param visitor -> The visitor of `sharded_table_for_each`
+ * @param context -> The context of the visitor
+ */
+typedef struct _sharded_table_job {
+  EmeraldsShardedTable *self;
+  size_t worker;
+  size_t workers;
+  const char **keys;
+  const size_t *values;
+  size_t n;
+  EmeraldsTableKey *handles;
+  size_t *order;
+  size_t *starts;
+  EmeraldsShardedVisitor visitor;
+  void *context;
+} _sharded_table_job;
+
+/**
+ * @brief Runs a job on every worker, the calling thread acts as worker 0 and
+ * any worker that fails to start runs on it as well
+ * @param work -> The job function
+ * @param jobs -> One job per worker
+ * @param workers -> The number of workers
+ */
+p_inline void _sharded_table_run(
+  void *(*work)(void *), _sharded_table_job *jobs, size_t workers
+) {
+  size_t w;
+  pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+  bool *started      = (bool *)malloc(workers * sizeof(bool));
+
+  for(w = 1; w < workers; w++) {
+    started[w] = pthread_create(&threads[w], NULL, work, &jobs[w]) == 0;
+  }
+  work(&jobs[0]);
+  for(w = 1; w < workers; w++) {
+    if(started[w]) {
+      pthread_join(threads[w], NULL);
+    } else {
+      work(&jobs[w]);
+    }
+  }
+
+  free(threads);
+  free(started);
+}
+
+/**
+ * @brief Prepares one job per worker, at most one worker per shard
+ * @param self -> The table
+ * @param threads -> The requested number of threads
+ * @param workers -> Receives the number of workers
+ * @return _sharded_table_job * -> The jobs
+ */
+p_inline _sharded_table_job *_sharded_table_jobs(
+  EmeraldsShardedTable *self, size_t threads, size_t *workers
+) {
+  size_t w;
+  size_t count = (size_t)1 << self->bits;
+  _sharded_table_job *jobs;
+
+  *workers = threads == 0 ? 1 : threads > count ? count : threads;
+  jobs = (_sharded_table_job *)calloc(*workers, sizeof(_sharded_table_job));
+  for(w = 0; w < *workers; w++) {
+    jobs[w].self    = self;
+    jobs[w].worker  = w;
+    jobs[w].workers = *workers;
+  }
+  return jobs;
+}
+
+/**
+ * @brief Hashes a contiguous range of the keys being loaded
+ * @param arg -> The job
+ * @return void * -> NULL
+ */
+static void *_sharded_table_hash_range(void *arg) {
+  _sharded_table_job *job = (_sharded_table_job *)arg;
+  size_t i                = job->n / job->workers * job->worker;
+  size_t end              = job->worker + 1 == job->workers
+                              ? job->n
+                              : job->n / job->workers * (job->worker + 1);
+
+  for(; i < end; i++) {
+    job->handles[i] = table_key(job->keys[i]);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Inserts the pairs of every shard owned by the worker, no other
+ * thread touches those shards so no lock is taken
+ * @param arg -> The job
+ * @return void * -> NULL
+ */
+static void *_sharded_table_fill_shards(void *arg) {
+  _sharded_table_job *job = (_sharded_table_job *)arg;
+  size_t count            = (size_t)1 << job->self->bits;
+  size_t shard;
+
+  for(shard = job->worker; shard < count; shard += job->workers) {
+    EmeraldsTable *table = &job->self->shards[shard].table;
+    size_t j;
+    for(j = job->starts[shard]; j < job->starts[shard + 1]; j++) {
+      size_t i = job->order[j];
+      table_add_h(table, &job->handles[i], job->values[i]);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Visits every entry of a table, including the part an incremental
+ * rehash has not migrated yet
+ * @param table -> The table
+ * @param job -> The job
+ * @param shard -> The shard index
+ */
+static void _sharded_table_visit(
+  EmeraldsTable *table, _sharded_table_job *job, size_t shard
+) {
+  size_t i;
+  for(i = 0; i < table->capacity; i++) {
+    if(TABLE_STATE_IS_FILLED(table->states[i])) {
+      job->visitor(
+        job->context,
+        shard,
+        TABLE_KEY_AT(table, i),
+        TABLE_LENGTH_AT(table, i),
+        TABLE_VALUE_AT(table, i)
+      );
+    }
+  }
+  #if defined(TABLE_INCREMENTAL_REHASH)
+  if(table->old != NULL) {
+    _sharded_table_visit(table->old, job, shard);
+  }
+  #endif
+}
+
+/**
+ * @brief Walks every shard owned by the worker under the shard's lock
+ * @param arg -> The job
+ * @return void * -> NULL
+ */
+static void *_sharded_table_visit_shards(void *arg) {
+  _sharded_table_job *job = (_sharded_table_job *)arg;
+  size_t count            = (size_t)1 << job->self->bits;
+  size_t shard;
+
+  for(shard = job->worker; shard < count; shard += job->workers) {
+    EmeraldsTableShard *entry = &job->self->shards[shard];
+    _sharded_table_lock(&entry->lock);
+    _sharded_table_visit(&entry->table, job, shard);
+    _sharded_table_unlock(&entry->lock);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Returns the shard of a hashed key
+ * @param self -> The table
+ * @param handle -> The key handle
+ * @return EmeraldsTableShard * -> The shard
+ */
+  #define _sharded_table_shard(self, handle) \
+    (&(self)->shards[SHARDED_TABLE_SHARD((handle).hash, (self)->bits)])
+
+void sharded_table_init(EmeraldsShardedTable *self, size_t bits) {
+  size_t i;
+  size_t count = (size_t)1 << bits;
+
+  self->bits   = bits;
+  self->shards =
+    (EmeraldsTableShard *)malloc(count * sizeof(EmeraldsTableShard));
+  for(i = 0; i < count; i++) {
+    table_init(&self->shards[i].table);
+    _sharded_table_lock_init(&self->shards[i].lock);
+  }
+}
+
+void sharded_table_build(
+  EmeraldsShardedTable *self,
+  size_t bits,
+  const char **keys,
+  const size_t *values,
+  size_t n,
+  size_t threads
+) {
+  size_t i;
+  size_t workers;
+  size_t count = (size_t)1 << bits;
+  EmeraldsTableKey *handles =
+    (EmeraldsTableKey *)malloc(n * sizeof(EmeraldsTableKey));
+  size_t *order  = (size_t *)malloc(n * sizeof(size_t));
+  size_t *starts = (size_t *)calloc(count + 1, sizeof(size_t));
+  _sharded_table_job *jobs;
+
+  sharded_table_init(self, bits);
+  jobs = _sharded_table_jobs(self, threads, &workers);
+  for(i = 0; i < workers; i++) {
+    jobs[i].keys    = keys;
+    jobs[i].values  = values;
+    jobs[i].n       = n;
+    jobs[i].handles = handles;
+    jobs[i].order   = order;
+    jobs[i].starts  = starts;
+  }
+  _sharded_table_run(_sharded_table_hash_range, jobs, workers);
+
+  /* Counting sort by shard, keeps the input order within every shard */
+  for(i = 0; i < n; i++) {
+    starts[SHARDED_TABLE_SHARD(handles[i].hash, bits) + 1]++;
+  }
+  for(i = 0; i < count; i++) {
+    starts[i + 1] += starts[i];
+  }
+  for(i = 0; i < n; i++) {
+    order[starts[SHARDED_TABLE_SHARD(handles[i].hash, bits)]++] = i;
+  }
+  for(i = count; i > 0; i--) {
+    starts[i] = starts[i - 1];
+  }
+  starts[0] = 0;
+
+  _sharded_table_run(_sharded_table_fill_shards, jobs, workers);
+
+  free(jobs);
+  free(handles);
+  free(order);
+  free(starts);
+}
+
+void sharded_table_add(
+  EmeraldsShardedTable *self, const char *key, size_t value
+) {
+  sharded_table_add_n(self, key, strlen(key), value);
+}
+
+void sharded_table_add_n(
+  EmeraldsShardedTable *self, const char *key, size_t keylen, size_t value
+) {
+  EmeraldsTableKey handle   = table_key_n(key, keylen);
+  EmeraldsTableShard *shard = _sharded_table_shard(self, handle);
+  _sharded_table_lock(&shard->lock);
+  table_add_h(&shard->table, &handle, value);
+  _sharded_table_unlock(&shard->lock);
+}
+
+size_t sharded_table_get(EmeraldsShardedTable *self, const char *key) {
+  return sharded_table_get_n(self, key, strlen(key));
+}
+
+size_t sharded_table_get_n(
+  EmeraldsShardedTable *self, const char *key, size_t keylen
+) {
+  size_t value;
+  EmeraldsTableKey handle   = table_key_n(key, keylen);
+  EmeraldsTableShard *shard = _sharded_table_shard(self, handle);
+  _sharded_table_lock(&shard->lock);
+  value = table_get_h(&shard->table, &handle);
+  _sharded_table_unlock(&shard->lock);
+  return value;
+}
+
+void sharded_table_remove(EmeraldsShardedTable *self, const char *key) {
+  sharded_table_remove_n(self, key, strlen(key));
+}
+
+void sharded_table_remove_n(
+  EmeraldsShardedTable *self, const char *key, size_t keylen
+) {
+  EmeraldsTableKey handle   = table_key_n(key, keylen);
+  EmeraldsTableShard *shard = _sharded_table_shard(self, handle);
+  _sharded_table_lock(&shard->lock);
+  table_remove_h(&shard->table, &handle);
+  _sharded_table_unlock(&shard->lock);
+}
+
+void sharded_table_for_each(
+  EmeraldsShardedTable *self,
+  EmeraldsShardedVisitor visitor,
+  void *context,
+  size_t threads
+) {
+  size_t i;
+  size_t workers;
+  _sharded_table_job *jobs = _sharded_table_jobs(self, threads, &workers);
+
+  for(i = 0; i < workers; i++) {
+    jobs[i].visitor = visitor;
+    jobs[i].context = context;
+  }
+  _sharded_table_run(_sharded_table_visit_shards, jobs, workers);
+  free(jobs);
+}
+
+size_t sharded_table_size(EmeraldsShardedTable *self) {
+  size_t i;
+  size_t size  = 0;
+  size_t count = (size_t)1 << self->bits;
+
+  for(i = 0; i < count; i++) {
+    _sharded_table_lock(&self->shards[i].lock);
+    size += table_size(&self->shards[i].table);
+    _sharded_table_unlock(&self->shards[i].lock);
+  }
+  return size;
+}
+
+void sharded_table_deinit(EmeraldsShardedTable *self) {
+  size_t i;
+  size_t count = (size_t)1 << self->bits;
+
+  for(i = 0; i < count; i++) {
+    table_deinit(&self->shards[i].table);
+    _sharded_table_lock_destroy(&self->shards[i].lock);
+  }
+  free(self->shards);
+  self->shards = NULL;
+}
+
+#else
+typedef int _sharded_table_requires_pthreads;
+#endif
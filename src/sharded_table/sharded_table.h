@@ -0,0 +1,191 @@
+#ifndef __SHARDED_TABLE_H_
+#define __SHARDED_TABLE_H_
+
+#include "../table/table.h"
+
+/* Needs POSIX threads for the shard locks and the parallel helpers */
+#if !defined(_WIN32)
+  #define SHARDED_TABLE_AVAILABLE
+
+  #include <pthread.h>
+
+  /** @brief Number of hash bits selecting the shard when none are given */
+  #ifndef SHARDED_TABLE_DEFAULT_BITS
+    #define SHARDED_TABLE_DEFAULT_BITS (4)
+  #endif
+
+  /**
+   * @brief Defining SHARDED_TABLE_SPINLOCK guards shards with a spinlock built
+   * on the __atomic builtins instead of a pthread mutex
+   */
+  #if defined(SHARDED_TABLE_SPINLOCK)
+    #if !defined(__ATOMIC_SEQ_CST)
+      #error "SHARDED_TABLE_SPINLOCK needs the __atomic builtins"
+    #endif
+typedef size_t EmeraldsShardedLock;
+  #else
+typedef pthread_mutex_t EmeraldsShardedLock;
+  #endif
+
+  /**
+   * @brief Selects the shard of a hash from the bits right below the top 7,
+   * the shards index their buckets with the low bits and group probing takes
+   * its fingerprints from the top 7, so all three stay independent
+   * @param hash -> The TABLE_HASH_FUNCTION hash of the key
+   * @param bits -> The number of shard bits
+   * @return size_t -> The shard index
+   */
+  #define SHARDED_TABLE_SHARD(hash, bits)                                \
+    ((bits) == 0 ? 0                                                   \
+                 : ((size_t)(hash) >> (sizeof(size_t) * 8 - 7 - (bits))) & \
+                     (((size_t)1 << (bits)) - 1))
+
+/**
+ * @brief An independent table and the lock guarding it
+ * @param table -> The table
+ * @param lock -> The lock
+ * @param padding -> Keeps the lock off the cache line of the next shard
+ */
+typedef struct EmeraldsTableShard {
+  EmeraldsTable table;
+  EmeraldsShardedLock lock;
+  char padding[TABLE_CACHE_LINE_SIZE];
+} EmeraldsTableShard;
+
+/**
+ * @brief Table split into 2^bits shards, each rehashing under its own lock so
+ * threads working on different shards never wait for each other
+ * @param shards -> The shards
+ * @param bits -> The number of hash bits selecting the shard
+ */
+typedef struct EmeraldsShardedTable {
+  EmeraldsTableShard *shards;
+  size_t bits;
+} EmeraldsShardedTable;
+
+/**
+ * @brief Called for every entry by `sharded_table_for_each`, concurrently for
+ * entries of different shards
+ * @param context -> The context passed to `sharded_table_for_each`
+ * @param shard -> The shard index, entries of one shard share a thread
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The value
+ */
+typedef void (*EmeraldsShardedVisitor)(
+  void *context, size_t shard, const char *key, size_t keylen, size_t value
+);
+
+/**
+ * @brief Initializes the table, not thread safe
+ * @param self -> The table
+ * @param bits -> The number of shard bits, 2^bits shards get created
+ */
+void sharded_table_init(EmeraldsShardedTable *self, size_t bits);
+
+/**
+ * @brief Initializes the table and bulk loads `n` pairs, keys are hashed by
+ * all workers in parallel and then every worker fills its own shards
+ * @param self -> The table (uninitialized)
+ * @param bits -> The number of shard bits
+ * @param keys -> The keys
+ * @param values -> The values
+ * @param n -> The number of pairs
+ * @param threads -> The number of worker threads, at most one per shard
+ */
+void sharded_table_build(
+  EmeraldsShardedTable *self,
+  size_t bits,
+  const char **keys,
+  const size_t *values,
+  size_t n,
+  size_t threads
+);
+
+/**
+ * @brief Inserts or updates a key, thread safe
+ * @param self -> The table
+ * @param key -> The key
+ * @param value -> The value
+ */
+void sharded_table_add(
+  EmeraldsShardedTable *self, const char *key, size_t value
+);
+
+/**
+ * @brief Inserts or updates a key of known length, thread safe
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The value
+ */
+void sharded_table_add_n(
+  EmeraldsShardedTable *self, const char *key, size_t keylen, size_t value
+);
+
+/**
+ * @brief Looks up a key, thread safe
+ * @param self -> The table
+ * @param key -> The key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t sharded_table_get(EmeraldsShardedTable *self, const char *key);
+
+/**
+ * @brief Looks up a key of known length, thread safe
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t sharded_table_get_n(
+  EmeraldsShardedTable *self, const char *key, size_t keylen
+);
+
+/**
+ * @brief Removes a key, thread safe
+ * @param self -> The table
+ * @param key -> The key
+ */
+void sharded_table_remove(EmeraldsShardedTable *self, const char *key);
+
+/**
+ * @brief Removes a key of known length, thread safe
+ * @param self -> The table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ */
+void sharded_table_remove_n(
+  EmeraldsShardedTable *self, const char *key, size_t keylen
+);
+
+/**
+ * @brief Visits every entry, each worker walks whole shards under their locks
+ * @param self -> The table
+ * @param visitor -> Called for every entry
+ * @param context -> Passed to the visitor
+ * @param threads -> The number of worker threads, at most one per shard
+ */
+void sharded_table_for_each(
+  EmeraldsShardedTable *self,
+  EmeraldsShardedVisitor visitor,
+  void *context,
+  size_t threads
+);
+
+/**
+ * @brief Returns the number of elements, thread safe
+ * @param self -> The table
+ * @return size_t -> The number of elements
+ */
+size_t sharded_table_size(EmeraldsShardedTable *self);
+
+/**
+ * @brief Deallocates every shard, not thread safe
+ * @param self -> The table
+ */
+void sharded_table_deinit(EmeraldsShardedTable *self);
+
+#endif
+
+#endif
@@ -1,27 +1,508 @@
+#if defined(TABLE_PARALLEL_REHASH) && !defined(_POSIX_C_SOURCE)
+  #define _POSIX_C_SOURCE 200112L
+#endif
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+  #define _DEFAULT_SOURCE
+#endif
+
 #include "table.h"
 
+#if defined(TABLE_PARALLEL_REHASH)
+  #include <pthread.h>
+#endif
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+
+  /* Linux 5.14, older headers lack it and older kernels reject it */
+  #ifndef MADV_POPULATE_WRITE
+    #define MADV_POPULATE_WRITE (23)
+  #endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+  #define _table_prefetch(address) __builtin_prefetch((address), 0, 3)
+#else
+  #define _table_prefetch(address) ((void)(address))
+#endif
+
+/** @brief Copies the cached key prefix of a bucket, if there is one */
+#if defined(TABLE_KEY_PREFIX)
+  #define _table_copy_prefix(dst, di, src, si) \
+    (TABLE_PREFIX_AT(dst, di) = TABLE_PREFIX_AT(src, si))
+#else
+  #define _table_copy_prefix(dst, di, src, si) ((void)0)
+#endif
+
+/**
+ * @brief Copies a bucket, together with its state, between tables
+ * @param dst -> The destination hash table
+ * @param di -> The destination bucket
+ * @param src -> The source hash table
+ * @param si -> The source bucket
+ */
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+  #define _table_copy_bucket(dst, di, src, si) \
+    do {                                       \
+      (dst)->slots[(di)]  = (src)->slots[(si)];  \
+      (dst)->states[(di)] = (src)->states[(si)]; \
+    } while(0)
+#else
+  #define _table_copy_bucket(dst, di, src, si)             \
+    do {                                                   \
+      TABLE_HASH_AT(dst, di)   = TABLE_HASH_AT(src, si);   \
+      TABLE_KEY_AT(dst, di)    = TABLE_KEY_AT(src, si);    \
+      TABLE_VALUE_AT(dst, di)  = TABLE_VALUE_AT(src, si);  \
+      TABLE_LENGTH_AT(dst, di) = TABLE_LENGTH_AT(src, si); \
+      _table_copy_prefix(dst, di, src, si);                \
+      (dst)->states[(di)]      = (src)->states[(si)];      \
+    } while(0)
+#endif
+
+/**
+ * @brief Points a bucket at a key, short keys are copied into the slot itself
+ * @param self -> The hash table
+ * @param i -> The bucket
+ * @param string -> The key
+ * @param keylen -> The length of the key
+ */
+#if defined(TABLE_INLINE_KEYS)
+  #define _table_set_key(self, i, string, keylen)                  \
+    do {                                                           \
+      if(TABLE_KEY_IS_INLINE(keylen)) {                            \
+        memmove((self)->slots[(i)].key.bytes, (string), (keylen)); \
+        (self)->slots[(i)].key.bytes[(keylen)] = '\0';             \
+      } else {                                                     \
+        (self)->slots[(i)].key.pointer = (string);                 \
+      }                                                            \
+    } while(0)
+#else
+  #define _table_set_key(self, i, string, keylen) \
+    ((void)(keylen), TABLE_KEY_AT(self, i) = (string))
+#endif
+
+#if defined(TABLE_KEY_PREFIX)
+/**
+ * @brief The first 8 bytes of a key, zero padded
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return uint64_t -> The prefix
+ */
+p_inline uint64_t _table_key_prefix(const char *key, size_t keylen) {
+  uint64_t prefix = 0;
+  memcpy(&prefix, key, keylen < sizeof(prefix) ? keylen : sizeof(prefix));
+  return prefix;
+}
+
+/**
+ * @brief Full key comparison of a filled bucket, short keys are settled by the
+ * cached prefix and only the tail of longer keys gets dereferenced
+ * @param self -> The hash table
+ * @param i -> The bucket
+ * @param hash -> The hash of the key
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ */
+  #define _table_key_equals(self, i, hash, key, keylen)                \
+    (TABLE_HASH_AT(self, i) == (hash) &&                               \
+     TABLE_LENGTH_AT(self, i) == (keylen) &&                           \
+     TABLE_PREFIX_AT(self, i) == _table_key_prefix((key), (keylen)) && \
+     ((keylen) <= 8 ||                                                 \
+      memcmp(TABLE_KEY_AT(self, i) + 8, (key) + 8, (keylen) - 8) == 0))
+#else
+/**
+ * @brief Full key comparison of a filled bucket, hash and length first so that
+ * the key itself is only dereferenced on a likely hit
+ * @param self -> The hash table
+ * @param i -> The bucket
+ * @param hash -> The hash of the key
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ */
+  #define _table_key_equals(self, i, hash, key, keylen) \
+    (TABLE_HASH_AT(self, i) == (hash) &&                \
+     TABLE_LENGTH_AT(self, i) == (keylen) &&            \
+     memcmp(TABLE_KEY_AT(self, i), (key), (keylen)) == 0)
+#endif
+
+#if TABLE_PROBING == TABLE_PROBING_GROUP
+  #if defined(__AVX2__)
+    #include <immintrin.h>
+    #define TABLE_GROUP_WIDTH (32)
+    #define TABLE_GROUP_SHIFT (0)
+  #elif defined(__SSE2__) || defined(_M_AMD64) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TABLE_GROUP_WIDTH (16)
+    #define TABLE_GROUP_SHIFT (0)
+  #else
+    #define TABLE_GROUP_WIDTH (8)
+    #define TABLE_GROUP_SHIFT (3)
+  #endif
+
+  /* Group loads read whole groups of the states array */
+  #if TABLE_INITIAL_SIZE < TABLE_GROUP_WIDTH
+    #error "TABLE_INITIAL_SIZE has to be at least TABLE_GROUP_WIDTH"
+  #endif
+
+  #define TABLE_GROUP_LSB ((uint64_t)0x0101010101010101)
+  #define TABLE_GROUP_LOW ((uint64_t)0x7f7f7f7f7f7f7f7f)
+  #define TABLE_GROUP_MSB ((uint64_t)0x8080808080808080)
+
+/**
+ * @brief Bitmask of matching slots in a group, one bit per slot for SIMD or
+ * one high bit per byte for the SWAR fallback (hence TABLE_GROUP_SHIFT)
+ */
+typedef uint64_t _table_mask;
+
+/**
+ * @brief Index of the lowest set slot of a non-empty mask
+ * @param mask -> The group mask
+ * @return size_t -> The offset of the slot within the group
+ */
+p_inline size_t _table_mask_first(_table_mask mask) {
+  #if defined(__GNUC__) || defined(__clang__)
+  return (size_t)__builtin_ctzll(mask) >> TABLE_GROUP_SHIFT;
+  #else
+  size_t i = 0;
+  while(!(mask & 1)) {
+    mask >>= 1;
+    i++;
+  }
+  return i >> TABLE_GROUP_SHIFT;
+  #endif
+}
+
+  #if TABLE_GROUP_SHIFT > 0
+/**
+ * @brief Loads 8 control bytes in little endian order regardless of host
+ * @param ctrl -> The first control byte of the group
+ * @return uint64_t -> The packed group
+ */
+p_inline uint64_t _table_group_load(const uint8_t *ctrl) {
+  return (uint64_t)ctrl[0] | ((uint64_t)ctrl[1] << 8) |
+         ((uint64_t)ctrl[2] << 16) | ((uint64_t)ctrl[3] << 24) |
+         ((uint64_t)ctrl[4] << 32) | ((uint64_t)ctrl[5] << 40) |
+         ((uint64_t)ctrl[6] << 48) | ((uint64_t)ctrl[7] << 56);
+}
+
+/**
+ * @brief Exact zero byte detection, no borrow can leak into neighbouring bytes
+ * @param word -> The packed group
+ * @return _table_mask -> High bit set for every zero byte
+ */
+p_inline _table_mask _table_group_zero_bytes(uint64_t word) {
+  return ~(((word & TABLE_GROUP_LOW) + TABLE_GROUP_LOW) | word) &
+         TABLE_GROUP_MSB;
+}
+  #endif
+
+/**
+ * @brief Matches every control byte of a group against a fingerprint
+ * @param ctrl -> The first control byte of the group
+ * @param byte -> The control byte to search for
+ * @return _table_mask -> The matching slots
+ */
+p_inline _table_mask _table_group_match(const uint8_t *ctrl, uint8_t byte) {
+  #if defined(__AVX2__)
+  __m256i group = _mm256_loadu_si256((const __m256i *)ctrl);
+  return (uint32_t)_mm256_movemask_epi8(
+    _mm256_cmpeq_epi8(group, _mm256_set1_epi8((char)byte))
+  );
+  #elif TABLE_GROUP_SHIFT == 0
+  __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+  return (uint32_t)_mm_movemask_epi8(
+    _mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte))
+  );
+  #else
+  return _table_group_zero_bytes(
+    _table_group_load(ctrl) ^ (TABLE_GROUP_LSB * byte)
+  );
+  #endif
+}
+
+/**
+ * @brief Matches every control byte that is not filled (empty or deleted)
+ * @param ctrl -> The first control byte of the group
+ * @return _table_mask -> The free slots
+ */
+p_inline _table_mask _table_group_match_free(const uint8_t *ctrl) {
+  #if defined(__AVX2__)
+  return (uint32_t)~_mm256_movemask_epi8(
+    _mm256_loadu_si256((const __m256i *)ctrl)
+  );
+  #elif TABLE_GROUP_SHIFT == 0
+  return (uint32_t)~_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl)) &
+         0xffff;
+  #else
+  return ~_table_group_load(ctrl) & TABLE_GROUP_MSB;
+  #endif
+}
+
+/**
+ * @brief Computes the control byte of a filled bucket from the top hash bits
+ * @param hash -> The hash of the key
+ * @return uint8_t -> The control byte
+ */
+p_inline uint8_t _table_control(size_t hash) {
+  return (uint8_t)(0x80 | (hash >> (sizeof(size_t) * 8 - 7)));
+}
+
+/**
+ * @brief Group probing bucket finder, `hashes` and `keys` are only loaded for
+ * slots whose 7 bit fingerprint matches
+ * @param self -> The hash table
+ * @param hash -> The hash of the key
+ * @param key -> The key to find
+ * @param keylen -> The length of the key
+ * @param find_empty -> A flag for when we are adding new keys
+ * @return size_t -> The index of the bucket or TABLE_UNDEFINED if not found
+ */
+p_inline size_t _table_find_bucket(
+  EmeraldsTable *self,
+  size_t hash,
+  const char *key,
+  size_t keylen,
+  bool find_empty
+) {
+  size_t i;
+  size_t bucket_count = self->capacity;
+  size_t group_index  = hash & (bucket_count - 1) & ~(TABLE_GROUP_WIDTH - 1);
+  size_t first_free   = TABLE_UNDEFINED;
+  uint8_t control     = _table_control(hash);
+
+  for(i = 0; i < bucket_count; i += TABLE_GROUP_WIDTH) {
+    const uint8_t *ctrl = self->states + group_index;
+    _table_mask mask    = _table_group_match(ctrl, control);
+
+    while(mask) {
+      size_t bucket_index = group_index + _table_mask_first(mask);
+      if(_table_key_equals(self, bucket_index, hash, key, keylen)) {
+        return bucket_index;
+      }
+      mask &= mask - 1;
+    }
+
+    if(find_empty && first_free == TABLE_UNDEFINED) {
+      mask = _table_group_match_free(ctrl);
+      if(mask) {
+        first_free = group_index + _table_mask_first(mask);
+      }
+    }
+    if(_table_group_match(ctrl, TABLE_STATE_EMPTY)) {
+      return first_free;
+    }
+
+    group_index = (group_index + TABLE_GROUP_WIDTH) & (bucket_count - 1);
+  }
+
+  return first_free;
+}
+
+/**
+ * @brief Places a key known to be absent in the first free slot of its probe
+ * sequence, used when moving entries into fresh arrays
+ * @param self -> The hash table
+ * @param hash -> The hash of the key
+ * @return size_t -> The index of the bucket
+ */
+p_inline size_t _table_find_free_bucket(EmeraldsTable *self, size_t hash) {
+  size_t bucket_count = self->capacity;
+  size_t group_index  = hash & (bucket_count - 1) & ~(TABLE_GROUP_WIDTH - 1);
+  _table_mask mask;
+
+  while(!(mask = _table_group_match_free(self->states + group_index))) {
+    group_index = (group_index + TABLE_GROUP_WIDTH) & (bucket_count - 1);
+  }
+
+  return group_index + _table_mask_first(mask);
+}
+
+/**
+ * @brief First free slot of a probe sequence ahead of the group holding an
+ * entry, used to slide entries back while purging tombstones in place
+ * @param self -> The hash table
+ * @param hash -> The hash of the entry
+ * @param bucket_index -> The bucket holding the entry
+ * @return size_t -> The free slot or `bucket_index` if no earlier group has one
+ */
+p_inline size_t
+_table_find_hole(EmeraldsTable *self, size_t hash, size_t bucket_index) {
+  size_t mask        = self->capacity - 1;
+  size_t group_index = hash & mask & ~(TABLE_GROUP_WIDTH - 1);
+  size_t own_group   = bucket_index & ~(TABLE_GROUP_WIDTH - 1);
+  _table_mask free_mask;
+
+  for(; group_index != own_group;
+      group_index = (group_index + TABLE_GROUP_WIDTH) & mask) {
+    free_mask = _table_group_match_free(self->states + group_index);
+    if(free_mask) {
+      return group_index + _table_mask_first(free_mask);
+    }
+  }
+  return bucket_index;
+}
+
+/**
+ * @brief Frees a bucket, a group that already has an empty slot terminates
+ * every probe passing through it so no tombstone is needed there
+ * @param self -> The hash table
+ * @param bucket_index -> The bucket to free
+ */
+p_inline void _table_erase_bucket(EmeraldsTable *self, size_t bucket_index) {
+  size_t group_index = bucket_index & ~(TABLE_GROUP_WIDTH - 1);
+  if(_table_group_match(self->states + group_index, TABLE_STATE_EMPTY)) {
+    self->states[bucket_index] = TABLE_STATE_EMPTY;
+  } else {
+    self->states[bucket_index] = TABLE_STATE_DELETED;
+    self->tombstones++;
+  }
+}
+#elif TABLE_PROBING == TABLE_PROBING_ROBIN_HOOD
+  #define _table_control(hash) (TABLE_STATE_FILLED)
+
+/**
+ * @brief Distance of a filled bucket from its home bucket
+ * @param self -> The hash table
+ * @param bucket_index -> The filled bucket
+ * @param mask -> The bucket count minus one
+ * @return size_t -> The probe distance
+ */
+  #define _table_probe_distance(self, bucket_index, mask) \
+    (((bucket_index) - (TABLE_HASH_AT(self, bucket_index) & (mask))) & (mask))
+
+/**
+ * @brief Shifts the run starting at a bucket one slot to the right, keeping
+ * clusters ordered by home bucket which is exactly what Robin Hood swapping
+ * would produce
+ * @param self -> The hash table
+ * @param bucket_index -> The bucket to open up
+ */
+p_inline void _table_open_bucket(EmeraldsTable *self, size_t bucket_index) {
+  size_t mask = self->capacity - 1;
+  size_t last = bucket_index;
+
+  while(self->states[last] != TABLE_STATE_EMPTY) {
+    last = (last + 1) & mask;
+  }
+  while(last != bucket_index) {
+    size_t prev = (last - 1) & mask;
+    _table_copy_bucket(self, last, self, prev);
+    last = prev;
+  }
+  self->states[bucket_index] = TABLE_STATE_EMPTY;
+}
+
+/**
+ * @brief Robin Hood bucket finder, a miss stops as soon as it meets a bucket
+ * closer to its home than the probe itself
+ * @param self -> The hash table
+ * @param hash -> The hash of the key
+ * @param key -> The key to find
+ * @param keylen -> The length of the key
+ * @param find_empty -> A flag for when we are adding new keys, opens up the
+ * bucket the key belongs to when it is missing
+ * @return size_t -> The index of the bucket or TABLE_UNDEFINED if not found
+ */
+p_inline size_t _table_find_bucket(
+  EmeraldsTable *self,
+  size_t hash,
+  const char *key,
+  size_t keylen,
+  bool find_empty
+) {
+  size_t distance;
+  size_t mask         = self->capacity - 1;
+  size_t bucket_index = hash & mask;
+
+  for(distance = 0; distance <= mask; distance++) {
+    if(self->states[bucket_index] == TABLE_STATE_EMPTY) {
+      return find_empty ? bucket_index : TABLE_UNDEFINED;
+    } else if(_table_probe_distance(self, bucket_index, mask) < distance) {
+      if(find_empty) {
+        _table_open_bucket(self, bucket_index);
+        return bucket_index;
+      } else {
+        return TABLE_UNDEFINED;
+      }
+    } else if(self->states[bucket_index] == TABLE_STATE_FILLED &&
+              _table_key_equals(self, bucket_index, hash, key, keylen)) {
+      return bucket_index;
+    }
+
+    bucket_index = (bucket_index + 1) & mask;
+  }
+
+  return TABLE_UNDEFINED;
+}
+
+/**
+ * @brief Opens up the bucket a key known to be absent belongs to
+ * @param self -> The hash table
+ * @param hash -> The hash of the key
+ * @return size_t -> The index of the bucket
+ */
+p_inline size_t _table_find_free_bucket(EmeraldsTable *self, size_t hash) {
+  size_t mask         = self->capacity - 1;
+  size_t bucket_index = hash & mask;
+  size_t distance     = 0;
+
+  while(self->states[bucket_index] != TABLE_STATE_EMPTY) {
+    if(_table_probe_distance(self, bucket_index, mask) < distance) {
+      _table_open_bucket(self, bucket_index);
+      break;
+    }
+    bucket_index = (bucket_index + 1) & mask;
+    distance++;
+  }
+
+  return bucket_index;
+}
+
+/**
+ * @brief Backward shift deletion, pulls the rest of the cluster one bucket
+ * closer to home so no tombstone is ever created
+ * @param self -> The hash table
+ * @param bucket_index -> The bucket to free
+ */
+p_inline void _table_erase_bucket(EmeraldsTable *self, size_t bucket_index) {
+  size_t mask = self->capacity - 1;
+  size_t next = (bucket_index + 1) & mask;
+
+  while(self->states[next] != TABLE_STATE_EMPTY &&
+        _table_probe_distance(self, next, mask) > 0) {
+    _table_copy_bucket(self, bucket_index, self, next);
+    bucket_index = next;
+    next         = (next + 1) & mask;
+  }
+  self->states[bucket_index] = TABLE_STATE_EMPTY;
+}
+#else
+/**
+ * @brief Computes the control byte of a filled bucket
+ * @param hash -> The hash of the key
+ * @return uint8_t -> The control byte
+ */
+  #define _table_control(hash) (TABLE_STATE_FILLED)
+
 /**
  * @brief Generic bucket finder
- * @param hashes -> The hashes array
- * @param states -> The states array
+ * @param self -> The hash table
  * @param hash -> The hash of the key
- * @param keys -> The keys vector
  * @param key -> The key to find
  * @param keylen -> The length of the key
  * @param find_empty -> A flag for when we are adding new keys
  * @return size_t -> The index of the bucket or TABLE_UNDEFINED if not found
  */
 p_inline size_t _table_find_bucket(
-  size_t *hashes,
-  uint8_t *states,
+  EmeraldsTable *self,
   size_t hash,
-  const char **keys,
   const char *key,
   size_t keylen,
   bool find_empty
 ) {
   size_t i;
-  size_t bucket_count  = vector_capacity(keys);
+  uint8_t *states      = self->states;
+  size_t bucket_count  = self->capacity;
   size_t bucket_index  = hash & (bucket_count - 1);
   size_t first_deleted = TABLE_UNDEFINED;
 
@@ -37,151 +518,1630 @@ p_inline size_t _table_find_bucket(
       if(find_empty && first_deleted == TABLE_UNDEFINED) {
         first_deleted = bucket_index;
       }
-    } else if(hashes[bucket_index] == hash &&
-              strncmp(keys[bucket_index], key, keylen) == 0) {
+    } else if(_table_key_equals(self, bucket_index, hash, key, keylen)) {
       return bucket_index;
     }
 
     bucket_index = (bucket_index + 1) & (bucket_count - 1);
   }
 
-  return TABLE_UNDEFINED;
+  return first_deleted;
 }
 
 /**
- * @brief Rehashes when bucket count reaches the load factor
+ * @brief Places a key known to be absent in the first empty bucket
  * @param self -> The hash table
+ * @param hash -> The hash of the key
+ * @return size_t -> The index of the bucket
  */
-p_inline void _table_rehash(EmeraldsTable *self) {
-  size_t i;
-  size_t *hashes_new    = NULL;
-  uint8_t *states_new   = NULL;
-  const char **keys_new = NULL;
-  size_t *values_new    = NULL;
-  size_t capacity       = vector_capacity(self->keys);
-  size_t capacity_new   = vector_capacity(self->keys) * TABLE_GROW_FACTOR;
-  if(capacity_new < TABLE_INITIAL_SIZE) {
-    capacity_new = TABLE_INITIAL_SIZE;
-  }
-  vector_initialize_n(hashes_new, capacity_new);
-  vector_initialize_n(states_new, capacity_new);
-  vector_initialize_n(keys_new, capacity_new);
-  vector_initialize_n(values_new, capacity_new);
-  for(i = 0; i < capacity; i++) {
-    if(self->states[i] == TABLE_STATE_FILLED) {
-      size_t hash         = self->hashes[i];
-      size_t bucket_index = hash & (capacity_new - 1);
-      while(states_new[bucket_index] == TABLE_STATE_FILLED) {
-        bucket_index = (bucket_index + 1) & (capacity_new - 1);
-      }
-      hashes_new[bucket_index] = hash;
-      states_new[bucket_index] = TABLE_STATE_FILLED;
-      keys_new[bucket_index]   = self->keys[i];
-      values_new[bucket_index] = self->values[i];
-    }
-  }
-  vector_free(self->keys);
-  vector_free(self->hashes);
-  vector_free(self->values);
-  vector_free(self->states);
-  self->keys       = keys_new;
-  self->hashes     = hashes_new;
-  self->values     = values_new;
-  self->states     = states_new;
-  self->tombstones = 0;
+p_inline size_t _table_find_free_bucket(EmeraldsTable *self, size_t hash) {
+  size_t bucket_count = self->capacity;
+  size_t bucket_index = hash & (bucket_count - 1);
+  while(self->states[bucket_index] == TABLE_STATE_FILLED) {
+    bucket_index = (bucket_index + 1) & (bucket_count - 1);
+  }
+  return bucket_index;
 }
 
-void table_init(EmeraldsTable *self) {
-  vector_initialize_n(self->keys, TABLE_INITIAL_SIZE);
-  vector_initialize_n(self->values, TABLE_INITIAL_SIZE);
-  vector_initialize_n(self->hashes, TABLE_INITIAL_SIZE);
-  vector_initialize_n(self->states, TABLE_INITIAL_SIZE);
-  self->size       = 0;
-  self->tombstones = 0;
+/**
+ * @brief First free bucket between the home of an entry and the entry itself,
+ * used to slide entries back while purging tombstones in place
+ * @param self -> The hash table
+ * @param hash -> The hash of the entry
+ * @param bucket_index -> The bucket holding the entry
+ * @return size_t -> The free bucket or `bucket_index` if there is none
+ */
+p_inline size_t
+_table_find_hole(EmeraldsTable *self, size_t hash, size_t bucket_index) {
+  size_t mask = self->capacity - 1;
+  size_t hole = hash & mask;
+  while(hole != bucket_index && self->states[hole] == TABLE_STATE_FILLED) {
+    hole = (hole + 1) & mask;
+  }
+  return hole;
 }
 
-void table_add(EmeraldsTable *self, const char *key, size_t value) {
-  size_t hash;
-  size_t bucket_index;
-  size_t prev_state;
-  size_t keylen;
-  if(self->size + (self->tombstones) >
-     vector_capacity(self->keys) * TABLE_LOAD_FACTOR) {
-    _table_rehash(self);
-  }
-  keylen       = strlen(key);
-  hash         = TABLE_HASH_FUNCTION(key, keylen);
-  bucket_index = _table_find_bucket(
-    self->hashes, self->states, hash, self->keys, key, keylen, true
-  );
-  prev_state = self->states[bucket_index];
-  if(bucket_index != TABLE_UNDEFINED) {
-    self->hashes[bucket_index] = hash;
-    self->keys[bucket_index]   = key;
-    self->values[bucket_index] = value;
-    self->states[bucket_index] = TABLE_STATE_FILLED;
-    if(prev_state != TABLE_STATE_FILLED) {
-      self->size++;
-      if(prev_state == TABLE_STATE_DELETED) {
-        self->tombstones--;
-      }
-    }
+/**
+ * @brief Frees a bucket by leaving a tombstone behind
+ * @param self -> The hash table
+ * @param bucket_index -> The bucket to free
+ */
+p_inline void _table_erase_bucket(EmeraldsTable *self, size_t bucket_index) {
+  self->states[bucket_index] = TABLE_STATE_DELETED;
+  self->tombstones++;
+}
+#endif
+
+/**
+ * @brief Faults in the whole pages of a fresh bucket array in one call, when
+ * the kernel refuses the pages simply fault in on first write
+ * @param memory -> The array
+ * @param bytes -> The size of the array
+ */
+p_inline void _table_prefault(void *memory, size_t bytes) {
+#if defined(__linux__)
+  size_t page  = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = ((size_t)memory + page - 1) & ~(page - 1);
+  size_t end   = ((size_t)memory + bytes) & ~(page - 1);
+  if(bytes >= TABLE_PREFAULT_MIN && end > start) {
+    madvise((void *)start, end - start, MADV_POPULATE_WRITE);
   }
+#else
+  (void)memory;
+  (void)bytes;
+#endif
 }
 
-void table_add_all(EmeraldsTable *src, EmeraldsTable *dst) {
-  size_t i;
-  for(i = 0; i < vector_capacity(src->keys); i++) {
-    if(src->states[i] == TABLE_STATE_FILLED) {
-      table_add(dst, src->keys[i], src->values[i]);
-    }
+#if defined(TABLE_INCREMENTAL_REHASH)
+/**
+ * @brief Drops the pages of an array that lie within a range of its elements,
+ * consecutive ranges tile the array so no page gets skipped between them
+ * @param memory -> The array
+ * @param from -> The first byte of the range
+ * @param to -> The byte past the range
+ */
+p_inline void _table_discard(void *memory, size_t from, size_t to) {
+  #if defined(__linux__)
+  size_t page  = (size_t)sysconf(_SC_PAGESIZE);
+  size_t first = ((size_t)memory + page - 1) & ~(page - 1);
+  size_t start = ((size_t)memory + from) & ~(page - 1);
+  size_t end   = ((size_t)memory + to) & ~(page - 1);
+  if(start < first) {
+    start = first;
   }
+  if(end > start) {
+    madvise((void *)start, end - start, MADV_DONTNEED);
+  }
+  #else
+  (void)memory;
+  (void)from;
+  (void)to;
+  #endif
 }
+#endif
 
-void table_add_all_non_labels(EmeraldsTable *src, EmeraldsTable *dst) {
-  size_t i;
-  for(i = 0; i < vector_capacity(src->keys); i++) {
-    if(src->states[i] == TABLE_STATE_FILLED) {
-      if(src->keys[i] && !(src->keys[i][0] == '@' && src->keys[i][1] == ':' &&
-                           src->keys[i][2] == ':')) {
-        table_add(dst, src->keys[i], src->values[i]);
-      }
-    }
+/**
+ * @brief Allocates table storage through the allocator of the table
+ * @param self -> The hash table
+ * @param bytes -> The size of the block
+ * @return void * -> The block
+ */
+p_inline void *_table_allocate(EmeraldsTable *self, size_t bytes) {
+  if(self->allocator != NULL) {
+    return self->allocator->allocate(self->allocator->context, bytes);
   }
+  return malloc(bytes);
 }
 
-size_t table_get(EmeraldsTable *self, const char *key) {
-  size_t keylen       = strlen(key);
-  size_t hash         = TABLE_HASH_FUNCTION(key, keylen);
-  size_t bucket_index = _table_find_bucket(
-    self->hashes, self->states, hash, self->keys, key, keylen, false
-  );
+/**
+ * @brief Allocates cleared table storage, without a custom allocator calloc
+ * hands large blocks over as fresh zero pages that only get touched (and
+ * cleared by the kernel) once written
+ * @param self -> The hash table
+ * @param bytes -> The size of the block
+ * @return void * -> The zeroed block
+ */
+p_inline void *_table_allocate_zeroed(EmeraldsTable *self, size_t bytes) {
+  void *memory;
+  if(self->allocator == NULL) {
+    return calloc(1, bytes);
+  }
+  memory = _table_allocate(self, bytes);
+  memset(memory, 0, bytes);
+  return memory;
+}
 
-  if(bucket_index != TABLE_UNDEFINED) {
-    return self->values[bucket_index];
+/**
+ * @brief Resizes table storage through the allocator of the table
+ * @param self -> The hash table
+ * @param memory -> The block
+ * @param old_bytes -> The size the block was allocated with
+ * @param bytes -> The new size
+ * @return void * -> The block holding the contents
+ */
+p_inline void *_table_reallocate(
+  EmeraldsTable *self, void *memory, size_t old_bytes, size_t bytes
+) {
+  if(self->allocator != NULL) {
+    return self->allocator->reallocate(
+      self->allocator->context, memory, old_bytes, bytes
+    );
+  }
+  return realloc(memory, bytes);
+}
+
+/**
+ * @brief Gives table storage back to the allocator of the table
+ * @param self -> The hash table
+ * @param memory -> The block, may be NULL
+ * @param bytes -> The size the block was allocated with
+ */
+p_inline void _table_release(EmeraldsTable *self, void *memory, size_t bytes) {
+  if(memory == NULL) {
+    return;
+  }
+  if(self->allocator != NULL) {
+    self->allocator->release(self->allocator->context, memory, bytes);
   } else {
-    return TABLE_UNDEFINED;
+    free(memory);
   }
 }
 
-void table_remove(EmeraldsTable *self, const char *key) {
-  size_t keylen       = strlen(key);
-  size_t hash         = TABLE_HASH_FUNCTION(key, keylen);
-  size_t bucket_index = _table_find_bucket(
-    self->hashes, self->states, hash, self->keys, key, keylen, false
-  );
-  if(bucket_index != TABLE_UNDEFINED) {
-    self->states[bucket_index] = TABLE_STATE_DELETED;
-    self->size--;
-    self->tombstones++;
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+/**
+ * @brief Size of the block holding `capacity` control bytes and slots, with
+ * room to align both to a cache line
+ * @param capacity -> The bucket count
+ * @return size_t -> The size of the block
+ */
+  #define _table_block_bytes(capacity)                                      \
+    (TABLE_CACHE_LINE_SIZE +                                                \
+     (((capacity) + TABLE_CACHE_LINE_SIZE - 1) &                            \
+      ~(size_t)(TABLE_CACHE_LINE_SIZE - 1)) +                               \
+     (capacity) * sizeof(EmeraldsTableSlot))
+
+/**
+ * @brief Allocates one cache line aligned block, control bytes first and then
+ * the slots, the block comes zeroed so every control byte is empty
+ * @param self -> The hash table
+ * @param capacity -> The bucket count, a power of two
+ * @param prefault -> Whether large arrays get faulted in right away
+ */
+p_inline void
+_table_allocate_buckets(EmeraldsTable *self, size_t capacity, bool prefault) {
+  size_t line        = TABLE_CACHE_LINE_SIZE;
+  size_t states_size = (capacity + line - 1) & ~(line - 1);
+  size_t misalignment;
+
+  self->block    = _table_allocate_zeroed(self, _table_block_bytes(capacity));
+  misalignment   = (size_t)self->block & (line - 1);
+  self->states   = (uint8_t *)self->block + (line - misalignment);
+  self->slots    = (EmeraldsTableSlot *)(self->states + states_size);
+  self->capacity = capacity;
+  if(prefault) {
+    _table_prefault(self->slots, capacity * sizeof(EmeraldsTableSlot));
   }
 }
 
-size_t table_size(EmeraldsTable *self) { return self->size; }
+/**
+ * @brief Deallocates the bucket block
+ * @param self -> The hash table
+ */
+p_inline void _table_free_buckets(EmeraldsTable *self) {
+  _table_release(self, self->block, _table_block_bytes(self->capacity));
+  self->block  = NULL;
+  self->states = NULL;
+  self->slots  = NULL;
+}
 
-void table_deinit(EmeraldsTable *self) {
-  vector_free(self->hashes);
-  vector_free(self->states);
-  vector_free(self->keys);
-  vector_free(self->values);
+  #if defined(TABLE_INCREMENTAL_REHASH)
+/**
+ * @brief Drops the slots of a range of migrated buckets, Robin Hood probes
+ * still read the hashes of moved buckets so its slots stay
+ * @param self -> The old generation
+ * @param from -> The first bucket
+ * @param to -> The bucket past the range
+ */
+p_inline void
+_table_discard_buckets(EmeraldsTable *self, size_t from, size_t to) {
+    #if TABLE_PROBING != TABLE_PROBING_ROBIN_HOOD
+  size_t width = sizeof(EmeraldsTableSlot);
+  _table_discard(self->slots, from * width, to * width);
+    #else
+  (void)self;
+  (void)from;
+  (void)to;
+    #endif
+}
+  #endif
+#else
+/**
+ * @brief Allocates empty bucket arrays, only the states come zeroed
+ * @param self -> The hash table
+ * @param capacity -> The bucket count, a power of two
+ * @param prefault -> Whether large arrays get faulted in right away
+ */
+p_inline void
+_table_allocate_buckets(EmeraldsTable *self, size_t capacity, bool prefault) {
+  self->keys = (const char **)_table_allocate(
+    self, capacity * sizeof(*self->keys)
+  );
+  self->values  = (size_t *)_table_allocate(self, capacity * sizeof(size_t));
+  self->hashes  = (size_t *)_table_allocate(self, capacity * sizeof(size_t));
+  self->lengths = (size_t *)_table_allocate(self, capacity * sizeof(size_t));
+#if defined(TABLE_KEY_PREFIX)
+  self->prefixes =
+    (uint64_t *)_table_allocate(self, capacity * sizeof(uint64_t));
+#endif
+  self->states   = (uint8_t *)_table_allocate_zeroed(self, capacity);
+  self->capacity = capacity;
+
+  if(prefault) {
+    _table_prefault(self->keys, capacity * sizeof(*self->keys));
+    _table_prefault(self->values, capacity * sizeof(*self->values));
+    _table_prefault(self->hashes, capacity * sizeof(*self->hashes));
+    _table_prefault(self->lengths, capacity * sizeof(*self->lengths));
+#if defined(TABLE_KEY_PREFIX)
+    _table_prefault(self->prefixes, capacity * sizeof(*self->prefixes));
+#endif
+    _table_prefault(self->states, capacity);
+  }
+}
+
+/**
+ * @brief Deallocates the bucket arrays
+ * @param self -> The hash table
+ */
+p_inline void _table_free_buckets(EmeraldsTable *self) {
+  size_t capacity = self->capacity;
+  _table_release(self, self->hashes, capacity * sizeof(size_t));
+  _table_release(self, self->lengths, capacity * sizeof(size_t));
+#if defined(TABLE_KEY_PREFIX)
+  _table_release(self, self->prefixes, capacity * sizeof(uint64_t));
+  self->prefixes = NULL;
+#endif
+  _table_release(self, self->states, capacity);
+  _table_release(self, (void *)self->keys, capacity * sizeof(*self->keys));
+  _table_release(self, self->values, capacity * sizeof(size_t));
+  self->hashes  = NULL;
+  self->lengths = NULL;
+  self->states  = NULL;
+  self->keys    = NULL;
+  self->values  = NULL;
+}
+
+  #if defined(TABLE_INCREMENTAL_REHASH)
+/**
+ * @brief Drops every array but the states (and the hashes Robin Hood probes
+ * still read) over a range of migrated buckets
+ * @param self -> The old generation
+ * @param from -> The first bucket
+ * @param to -> The bucket past the range
+ */
+p_inline void
+_table_discard_buckets(EmeraldsTable *self, size_t from, size_t to) {
+  size_t width = sizeof(size_t);
+  _table_discard((void *)self->keys, from * width, to * width);
+  _table_discard(self->values, from * width, to * width);
+  _table_discard(self->lengths, from * width, to * width);
+    #if TABLE_PROBING != TABLE_PROBING_ROBIN_HOOD
+  _table_discard(self->hashes, from * width, to * width);
+    #endif
+    #if defined(TABLE_KEY_PREFIX)
+  _table_discard(self->prefixes, from * width, to * width);
+    #endif
+}
+  #endif
+#endif
+
+#if defined(TABLE_OWNED_KEYS)
+/**
+ * @brief Starts a new arena chunk
+ * @param self -> The hash table
+ * @param capacity -> The number of key bytes of the chunk
+ */
+p_inline void _table_arena_grow(EmeraldsTable *self, size_t capacity) {
+  EmeraldsTableArenaChunk *chunk = (EmeraldsTableArenaChunk *)_table_allocate(
+    self, sizeof(EmeraldsTableArenaChunk) + capacity
+  );
+  chunk->prev       = self->arena.chunk;
+  chunk->capacity   = capacity;
+  self->arena.chunk = chunk;
+  self->arena.used  = 0;
+}
+
+/**
+ * @brief Copies a key and its NUL terminator into the arena
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return const char * -> The copy owned by the arena
+ */
+p_inline const char *
+_table_arena_copy(EmeraldsTable *self, const char *key, size_t keylen) {
+  char *copy;
+  size_t needed             = keylen + 1;
+  EmeraldsTableArena *arena = &self->arena;
+  if(arena->chunk == NULL || arena->used + needed > arena->chunk->capacity) {
+    _table_arena_grow(
+      self, needed > TABLE_ARENA_CHUNK_SIZE ? needed : TABLE_ARENA_CHUNK_SIZE
+    );
+  }
+
+  copy = (char *)(arena->chunk + 1) + arena->used;
+  memcpy(copy, key, keylen);
+  copy[keylen] = '\0';
+  arena->used += needed;
+  arena->bytes += needed;
+  return copy;
+}
+
+/**
+ * @brief Deallocates every chunk of an arena
+ * @param self -> The hash table whose allocator the chunks came from
+ * @param arena -> The key arena
+ */
+p_inline void
+_table_arena_free(EmeraldsTable *self, EmeraldsTableArena *arena) {
+  while(arena->chunk != NULL) {
+    EmeraldsTableArenaChunk *prev = arena->chunk->prev;
+    _table_release(
+      self,
+      arena->chunk,
+      sizeof(EmeraldsTableArenaChunk) + arena->chunk->capacity
+    );
+    arena->chunk = prev;
+  }
+  arena->used    = 0;
+  arena->bytes   = 0;
+  arena->garbage = 0;
+}
+
+/**
+ * @brief Copies the live keys into a fresh arena in bucket order, so keys of
+ * neighbouring buckets share cache lines, and drops the removed ones
+ * @param self -> The hash table (no pending migration)
+ */
+p_inline void _table_arena_compact(EmeraldsTable *self) {
+  size_t i;
+  size_t live                  = 0;
+  EmeraldsTableArena old_arena = self->arena;
+
+  for(i = 0; i < self->capacity; i++) {
+    if(TABLE_STATE_IS_FILLED(self->states[i]) &&
+       !TABLE_KEY_IS_INLINE(TABLE_LENGTH_AT(self, i))) {
+      live += TABLE_LENGTH_AT(self, i) + 1;
+    }
+  }
+
+  memset(&self->arena, 0, sizeof(self->arena));
+  _table_arena_grow(
+    self, live > TABLE_ARENA_CHUNK_SIZE ? live : TABLE_ARENA_CHUNK_SIZE
+  );
+  for(i = 0; i < self->capacity; i++) {
+    size_t keylen = TABLE_LENGTH_AT(self, i);
+    if(TABLE_STATE_IS_FILLED(self->states[i]) && !TABLE_KEY_IS_INLINE(keylen)) {
+      _table_set_key(
+        self,
+        i,
+        _table_arena_copy(self, TABLE_KEY_AT(self, i), keylen),
+        keylen
+      );
+    }
+  }
+  _table_arena_free(self, &old_arena);
+}
+
+/**
+ * @brief Whether removed keys take up most of the arena
+ * @param self -> The hash table
+ */
+  #define _table_arena_is_sparse(self)                    \
+    ((self)->arena.garbage > TABLE_ARENA_CHUNK_SIZE &&     \
+     (self)->arena.garbage * 2 > (self)->arena.bytes)
+#endif
+
+/**
+ * @brief Writes a key and its value into a bucket, new keys are counted and
+ * copied into the arena under TABLE_OWNED_KEYS
+ * @param self -> The hash table
+ * @param bucket_index -> The bucket, either free or holding the key already
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param hash -> The hash of the key
+ * @param value -> The value
+ */
+p_inline void _table_fill_bucket(
+  EmeraldsTable *self,
+  size_t bucket_index,
+  const char *key,
+  size_t keylen,
+  size_t hash,
+  size_t value
+) {
+  size_t prev_state = self->states[bucket_index];
+#if defined(TABLE_OWNED_KEYS)
+  if(TABLE_STATE_IS_FILLED(prev_state)) {
+    key = TABLE_KEY_AT(self, bucket_index);
+  } else if(!TABLE_KEY_IS_INLINE(keylen)) {
+    key = _table_arena_copy(self, key, keylen);
+  }
+#endif
+  _table_set_key(self, bucket_index, key, keylen);
+  TABLE_HASH_AT(self, bucket_index)   = hash;
+  TABLE_LENGTH_AT(self, bucket_index) = keylen;
+#if defined(TABLE_KEY_PREFIX)
+  TABLE_PREFIX_AT(self, bucket_index) = _table_key_prefix(key, keylen);
+#endif
+  TABLE_VALUE_AT(self, bucket_index)  = value;
+  self->states[bucket_index]          = _table_control(hash);
+  if(!TABLE_STATE_IS_FILLED(prev_state)) {
+    self->size++;
+    if(prev_state == TABLE_STATE_DELETED) {
+      self->tombstones--;
+    }
+  }
+}
+
+/**
+ * @brief Whether the table is empty or keeps its entries packed in the first
+ * `size` buckets of at most TABLE_SMALL_SIZE, scanned instead of probed
+ * @param self -> The hash table
+ */
+#define _table_is_small(self) ((self)->capacity <= TABLE_SMALL_SIZE)
+
+/**
+ * @brief Scans the packed entries of a small table, the stored hash is
+ * compared first so keys only get dereferenced on a likely hit
+ * @param self -> The hash table
+ * @param hash -> The hash of the key
+ * @param key -> The key to find
+ * @param keylen -> The length of the key
+ * @return size_t -> The index of the bucket or TABLE_UNDEFINED if not found
+ */
+p_inline size_t _table_small_find(
+  EmeraldsTable *self, size_t hash, const char *key, size_t keylen
+) {
+  size_t i;
+  for(i = 0; i < self->size; i++) {
+    if(_table_key_equals(self, i, hash, key, keylen)) {
+      return i;
+    }
+  }
+  return TABLE_UNDEFINED;
+}
+
+/**
+ * @brief Inserts or updates a key of a small table, the first insert
+ * allocates the buckets and new keys are appended
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param hash -> The hash of the key
+ * @param value -> The value
+ * @return bool -> false when a new key does not fit and the table must grow
+ */
+p_inline bool _table_small_add(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t hash, size_t value
+) {
+  size_t bucket_index = _table_small_find(self, hash, key, keylen);
+  if(bucket_index == TABLE_UNDEFINED) {
+    if(self->size == self->capacity) {
+      if(self->capacity > 0 || TABLE_SMALL_SIZE == 0) {
+        return false;
+      }
+      _table_allocate_buckets(self, TABLE_SMALL_SIZE, false);
+    }
+    bucket_index = self->size;
+  }
+  _table_fill_bucket(self, bucket_index, key, keylen, hash, value);
+  return true;
+}
+
+/**
+ * @brief Frees a bucket of a small table, the last entry takes its place so
+ * the entries stay packed
+ * @param self -> The hash table
+ * @param bucket_index -> The bucket to free
+ */
+p_inline void _table_small_erase(EmeraldsTable *self, size_t bucket_index) {
+  size_t last = self->size - 1;
+  if(bucket_index != last) {
+    _table_copy_bucket(self, bucket_index, self, last);
+  }
+  self->states[last] = TABLE_STATE_EMPTY;
+  self->size--;
+}
+
+/**
+ * @brief Copies a bucket into the first free bucket of its probe sequence
+ * @param self -> The destination hash table
+ * @param src -> The source hash table
+ * @param i -> The filled bucket of the source
+ */
+p_inline void
+_table_move_bucket(EmeraldsTable *self, EmeraldsTable *src, size_t i) {
+  size_t bucket_index = _table_find_free_bucket(self, TABLE_HASH_AT(src, i));
+  if(self->states[bucket_index] == TABLE_STATE_DELETED) {
+    self->tombstones--;
+  }
+  _table_copy_bucket(self, bucket_index, src, i);
+}
+
+#if defined(TABLE_PARALLEL_REHASH) && \
+  TABLE_PROBING != TABLE_PROBING_ROBIN_HOOD
+/**
+ * @brief The chunks of old home buckets one rehash thread moves, a chunk
+ * [start, end) owns the new home ranges [start, end) + k * old capacity
+ * @param dst -> The new hash table
+ * @param src -> The old hash table
+ * @param first_chunk -> The first chunk of the thread
+ * @param chunk_count -> The number of chunks, a power of two
+ * @param threads -> The number of threads, chunks are dealt round robin
+ * @param deferred -> Old buckets whose new probe sequence leaves its range
+ */
+typedef struct _table_rehash_job {
+  EmeraldsTable *dst;
+  EmeraldsTable *src;
+  size_t first_chunk;
+  size_t chunk_count;
+  size_t threads;
+  size_t *deferred;
+} _table_rehash_job;
+
+  #if TABLE_PROBING == TABLE_PROBING_GROUP
+/**
+ * @brief Unwrapped end of the groups a probe can run through past a chunk,
+ * probes stop at the first group holding an empty slot
+ * @param self -> The old hash table
+ * @param from -> The end of the chunk
+ * @return size_t -> The end of the last group to scan, may exceed capacity
+ */
+p_inline size_t _table_cluster_end(EmeraldsTable *self, size_t from) {
+  size_t mask = self->capacity - 1;
+  while(!_table_group_match(self->states + (from & mask), TABLE_STATE_EMPTY)) {
+    from += TABLE_GROUP_WIDTH;
+  }
+  return from + TABLE_GROUP_WIDTH;
+}
+
+/**
+ * @brief First free slot of a probe sequence that stays below `end`
+ * @param self -> The new hash table
+ * @param hash -> The hash of the key
+ * @param end -> The end of the range owned by the caller
+ * @return size_t -> The bucket or TABLE_UNDEFINED if the probe leaves the range
+ */
+p_inline size_t
+_table_find_free_bucket_before(EmeraldsTable *self, size_t hash, size_t end) {
+  size_t group_index = hash & (self->capacity - 1) & ~(TABLE_GROUP_WIDTH - 1);
+  for(; group_index < end; group_index += TABLE_GROUP_WIDTH) {
+    _table_mask mask = _table_group_match_free(self->states + group_index);
+    if(mask) {
+      return group_index + _table_mask_first(mask);
+    }
+  }
+  return TABLE_UNDEFINED;
+}
+  #else
+/**
+ * @brief Unwrapped end of the cluster a probe can run through past a chunk,
+ * tombstones keep the cluster going
+ * @param self -> The old hash table
+ * @param from -> The end of the chunk
+ * @return size_t -> The first empty bucket, may exceed capacity
+ */
+p_inline size_t _table_cluster_end(EmeraldsTable *self, size_t from) {
+  size_t mask = self->capacity - 1;
+  while(self->states[from & mask] != TABLE_STATE_EMPTY) {
+    from++;
+  }
+  return from;
+}
+
+/**
+ * @brief First free bucket of a probe sequence that stays below `end`
+ * @param self -> The new hash table
+ * @param hash -> The hash of the key
+ * @param end -> The end of the range owned by the caller
+ * @return size_t -> The bucket or TABLE_UNDEFINED if the probe leaves the range
+ */
+p_inline size_t
+_table_find_free_bucket_before(EmeraldsTable *self, size_t hash, size_t end) {
+  size_t bucket_index = hash & (self->capacity - 1);
+  while(bucket_index < end &&
+        self->states[bucket_index] == TABLE_STATE_FILLED) {
+    bucket_index++;
+  }
+  return bucket_index < end ? bucket_index : TABLE_UNDEFINED;
+}
+  #endif
+
+/**
+ * @brief Moves every entry whose old home lies in the thread's chunks, the
+ * scan follows clusters past the chunk end (wrapping around the array) and
+ * skips entries that spilled in from the previous chunk
+ * @param arg -> The job
+ * @return void * -> NULL
+ */
+static void *_table_rehash_chunks(void *arg) {
+  _table_rehash_job *job = (_table_rehash_job *)arg;
+  EmeraldsTable *dst     = job->dst;
+  EmeraldsTable *src     = job->src;
+  size_t mask            = src->capacity - 1;
+  size_t chunk_size      = src->capacity / job->chunk_count;
+  size_t chunk;
+
+  for(chunk = job->first_chunk; chunk < job->chunk_count;
+      chunk += job->threads) {
+    size_t start = chunk * chunk_size;
+    size_t end   = start + chunk_size;
+    size_t last  = _table_cluster_end(src, end);
+    size_t i;
+
+    for(i = start; i < last; i++) {
+      size_t bucket_index = i & mask;
+      size_t hash;
+      size_t home;
+      size_t target;
+      if(!TABLE_STATE_IS_FILLED(src->states[bucket_index])) {
+        continue;
+      }
+
+      hash = TABLE_HASH_AT(src, bucket_index);
+      home = hash & mask;
+      if(home < start || home >= end) {
+        continue;
+      }
+
+      /* The new home keeps the old one in its low bits */
+      target = _table_find_free_bucket_before(
+        dst, hash, end + (hash & (dst->capacity - 1) & ~mask)
+      );
+      if(target == TABLE_UNDEFINED) {
+        vector_add(job->deferred, bucket_index);
+      } else {
+        _table_copy_bucket(dst, target, src, bucket_index);
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Grows into `dst` with `rehash_threads` threads, the calling thread
+ * takes part and entries that overflow their range are placed afterwards
+ * @param dst -> The new hash table (empty, larger)
+ * @param src -> The old hash table
+ */
+p_inline void _table_parallel_move(EmeraldsTable *dst, EmeraldsTable *src) {
+  size_t t;
+  size_t i;
+  size_t threads     = src->rehash_threads;
+  size_t chunk_count = 1;
+  _table_rehash_job *jobs;
+  pthread_t *workers;
+  bool *started;
+
+  /* Chunks stay whole cache lines, which also keeps groups whole */
+  while(chunk_count < threads * TABLE_REHASH_CHUNKS_PER_THREAD &&
+        chunk_count * TABLE_CACHE_LINE_SIZE < src->capacity) {
+    chunk_count *= 2;
+  }
+  if(threads > chunk_count) {
+    threads = chunk_count;
+  }
+
+  jobs    = (_table_rehash_job *)malloc(threads * sizeof(_table_rehash_job));
+  workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+  started = (bool *)malloc(threads * sizeof(bool));
+  for(t = 0; t < threads; t++) {
+    jobs[t].dst         = dst;
+    jobs[t].src         = src;
+    jobs[t].first_chunk = t;
+    jobs[t].chunk_count = chunk_count;
+    jobs[t].threads     = threads;
+    jobs[t].deferred    = NULL;
+  }
+
+  for(t = 1; t < threads; t++) {
+    started[t] =
+      pthread_create(&workers[t], NULL, _table_rehash_chunks, &jobs[t]) == 0;
+  }
+  _table_rehash_chunks(&jobs[0]);
+  for(t = 1; t < threads; t++) {
+    if(started[t]) {
+      pthread_join(workers[t], NULL);
+    } else {
+      _table_rehash_chunks(&jobs[t]);
+    }
+  }
+
+  for(t = 0; t < threads; t++) {
+    for(i = 0; i < vector_size(jobs[t].deferred); i++) {
+      _table_move_bucket(dst, src, jobs[t].deferred[i]);
+    }
+    vector_free(jobs[t].deferred);
+  }
+
+  free(jobs);
+  free(workers);
+  free(started);
+}
+#endif
+
+#if TABLE_PROBING == TABLE_PROBING_ROBIN_HOOD
+/**
+ * @brief Moves every entry in old bucket order, starting past an empty bucket
+ * so that no cluster is split by the wrap around. Robin Hood clusters are
+ * sorted by home, so new homes rise along one front per multiple of the old
+ * capacity (two when doubling) and an entry lands right after its front
+ * without comparing probe distances or shifting runs, only entries whose slot
+ * is taken (a run spilling over from the previous front) take the full path
+ * @param dst -> The new hash table (empty)
+ * @param src -> The old hash table
+ */
+p_inline void _table_move_in_order(EmeraldsTable *dst, EmeraldsTable *src) {
+  size_t i;
+  size_t first;
+  size_t old_bits = 0;
+  size_t new_mask = dst->capacity - 1;
+  size_t fronts =
+    dst->capacity > src->capacity ? dst->capacity / src->capacity : 1;
+  size_t *last_home = (size_t *)calloc(fronts, sizeof(size_t));
+  size_t *next_free = (size_t *)calloc(fronts, sizeof(size_t));
+
+  while(((size_t)1 << old_bits) < src->capacity) {
+    old_bits++;
+  }
+
+  for(first = 0; src->states[first] != TABLE_STATE_EMPTY; first++) {
+  }
+  for(i = first + 1; i <= first + src->capacity; i++) {
+    size_t bucket_index = i & (src->capacity - 1);
+    size_t home;
+    size_t front;
+    size_t target;
+    if(src->states[bucket_index] != TABLE_STATE_FILLED) {
+      continue;
+    }
+
+    home   = TABLE_HASH_AT(src, bucket_index) & new_mask;
+    front  = home >> old_bits;
+    target = home;
+    /* Everything from the front's last home up to the front is filled with
+     * entries of smaller or equal homes */
+    if(home >= last_home[front] && next_free[front] > home) {
+      target = next_free[front] & new_mask;
+    }
+    if(dst->states[target] != TABLE_STATE_EMPTY) {
+      target = _table_find_free_bucket(dst, TABLE_HASH_AT(src, bucket_index));
+    }
+
+    _table_copy_bucket(dst, target, src, bucket_index);
+    last_home[front] = home;
+    next_free[front] = target + 1;
+  }
+
+  free(last_home);
+  free(next_free);
+}
+#endif
+
+/**
+ * @brief Moves every entry into empty new bucket arrays
+ * @param dst -> The new hash table
+ * @param src -> The old hash table
+ */
+p_inline void _table_move_buckets(EmeraldsTable *dst, EmeraldsTable *src) {
+  size_t i;
+  if(_table_is_small(src)) {
+    /* Packed entries keep their index unless they get hashed */
+    for(i = 0; i < src->size; i++) {
+      if(_table_is_small(dst)) {
+        _table_copy_bucket(dst, i, src, i);
+      } else {
+        _table_move_bucket(dst, src, i);
+      }
+    }
+    return;
+  }
+#if defined(TABLE_PARALLEL_REHASH) && \
+  TABLE_PROBING != TABLE_PROBING_ROBIN_HOOD
+  if(dst->capacity > src->capacity &&
+     src->capacity >= TABLE_PARALLEL_REHASH_MIN && src->rehash_threads > 1) {
+    _table_parallel_move(dst, src);
+    return;
+  }
+#endif
+#if TABLE_PROBING == TABLE_PROBING_ROBIN_HOOD
+  (void)i;
+  _table_move_in_order(dst, src);
+#else
+  /* Old buckets are read in order and entries stay near them, so writes
+   * already stream along bucket i and i + old capacity of the new arrays */
+  for(i = 0; i < src->capacity; i++) {
+    if(TABLE_STATE_IS_FILLED(src->states[i])) {
+      _table_move_bucket(dst, src, i);
+    }
+  }
+#endif
+}
+
+#if defined(TABLE_INCREMENTAL_REHASH)
+/**
+ * @brief Moves up to `steps` buckets of the old generation into the new one,
+ * moved buckets turn into tombstones so old probe sequences stay intact
+ * @param self -> The hash table
+ * @param steps -> The number of old buckets to visit
+ */
+p_inline void _table_migrate(EmeraldsTable *self, size_t steps) {
+  EmeraldsTable *old = self->old;
+  size_t capacity    = old->capacity;
+  size_t start       = self->migrated;
+  size_t end         = self->migrated + steps;
+  if(end > capacity) {
+    end = capacity;
+  }
+
+  for(; self->migrated < end; self->migrated++) {
+    if(TABLE_STATE_IS_FILLED(old->states[self->migrated])) {
+      _table_move_bucket(self, old, self->migrated);
+      old->states[self->migrated] = TABLE_STATE_DELETED;
+      old->size--;
+    }
+  }
+
+  /* Moved entries are never read again, only their states guide probes */
+  if(end / TABLE_REHASH_DISCARD > start / TABLE_REHASH_DISCARD &&
+     end < capacity) {
+    _table_discard_buckets(
+      old,
+      start / TABLE_REHASH_DISCARD * TABLE_REHASH_DISCARD,
+      end / TABLE_REHASH_DISCARD * TABLE_REHASH_DISCARD
+    );
+  }
+
+  if(self->migrated == capacity) {
+    _table_free_buckets(old);
+    _table_release(self, old, sizeof(EmeraldsTable));
+    self->old = NULL;
+  }
+}
+
+/**
+ * @brief Number of occupied buckets (live or tombstones) of the new generation
+ * @param self -> The hash table
+ * @return size_t -> The load of the newest bucket arrays
+ */
+p_inline size_t _table_load(EmeraldsTable *self) {
+  return self->size + self->tombstones - (self->old ? self->old->size : 0);
+}
+#else
+  #define _table_load(self) ((self)->size + (self)->tombstones)
+#endif
+
+/**
+ * @brief Smallest bucket count that holds `count` entries under the load factor
+ * @param count -> The number of entries
+ * @return size_t -> The bucket count, a power of two
+ */
+p_inline size_t _table_capacity_for(size_t count) {
+  size_t capacity = TABLE_INITIAL_SIZE;
+  while(count > capacity * TABLE_LOAD_FACTOR) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+/**
+ * @brief Moves every entry into `capacity_new` freshly allocated buckets
+ * @param self -> The hash table
+ * @param capacity_new -> The new bucket count, a power of two
+ */
+p_inline void _table_resize(EmeraldsTable *self, size_t capacity_new) {
+  EmeraldsTable new_table;
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_migrate(self, self->old->capacity);
+  }
+#endif
+  new_table = *self;
+  _table_allocate_buckets(&new_table, capacity_new, true);
+  new_table.tombstones = 0;
+  _table_move_buckets(&new_table, self);
+  _table_free_buckets(self);
+#if defined(TABLE_OWNED_KEYS)
+  _table_arena_compact(&new_table);
+#endif
+  *self = new_table;
+}
+
+#if TABLE_PROBING == TABLE_PROBING_ROBIN_HOOD
+  /** @brief Robin Hood removals shift entries back and leave no tombstones */
+  #define _table_purge(self) ((void)(self))
+#else
+/**
+ * @brief Drops the tombstones without reallocating, they become empty buckets
+ * and one sweep slides every entry cut off from its home back into the first
+ * hole of its probe sequence, the sweep starts past a group (or bucket) that
+ * was already empty so no probe sequence wraps into it
+ * @param self -> The hash table (no pending migration)
+ */
+p_inline void _table_purge(EmeraldsTable *self) {
+  size_t i;
+  size_t hole;
+  size_t bucket_index;
+  size_t start = 0;
+  size_t mask  = self->capacity - 1;
+  #if TABLE_PROBING == TABLE_PROBING_GROUP
+  size_t width = TABLE_GROUP_WIDTH;
+  #else
+  size_t width = 1;
+  #endif
+
+  if(self->tombstones == 0) {
+    return;
+  }
+  while(start < self->capacity && self->states[start] != TABLE_STATE_EMPTY) {
+    start++;
+  }
+  if(start == self->capacity) {
+    _table_resize(self, self->capacity);
+    return;
+  }
+  start &= ~(width - 1);
+
+  for(i = 0; i < self->capacity; i++) {
+    if(self->states[i] == TABLE_STATE_DELETED) {
+      self->states[i] = TABLE_STATE_EMPTY;
+    }
+  }
+  for(i = width; i < self->capacity + width; i++) {
+    bucket_index = (start + i) & mask;
+    if(TABLE_STATE_IS_FILLED(self->states[bucket_index])) {
+      hole = _table_find_hole(
+        self, TABLE_HASH_AT(self, bucket_index), bucket_index
+      );
+      if(hole != bucket_index) {
+        _table_copy_bucket(self, hole, self, bucket_index);
+        self->states[bucket_index] = TABLE_STATE_EMPTY;
+      }
+    }
+  }
+  self->tombstones = 0;
+}
+#endif
+
+#if defined(TABLE_LAYOUT_INTERLEAVED) || defined(TABLE_INCREMENTAL_REHASH) || \
+  TABLE_PROBING == TABLE_PROBING_ROBIN_HOOD
+  /** @brief Only split layout linear and group probing tables grow in place */
+  #define _table_grow_in_place(self) ((void)(self), false)
+#else
+/**
+ * @brief Doubles the length of a bucket array in place
+ * @param self -> The hash table
+ * @param memory -> The array
+ * @param bytes -> The current size of the array
+ * @return void * -> The array, possibly remapped elsewhere
+ */
+p_inline void *_table_extend(EmeraldsTable *self, void *memory, size_t bytes) {
+  memory = _table_reallocate(self, memory, bytes, 2 * bytes);
+  _table_prefault((char *)memory + bytes, bytes);
+  return memory;
+}
+
+/**
+ * @brief Exchanges the entries of two buckets, leaving their states as is
+ * @param self -> The hash table
+ * @param a -> The first bucket
+ * @param b -> The second bucket
+ */
+p_inline void _table_swap_buckets(EmeraldsTable *self, size_t a, size_t b) {
+  size_t hash     = self->hashes[a];
+  const char *key = self->keys[a];
+  size_t value    = self->values[a];
+  size_t length   = self->lengths[a];
+  #if defined(TABLE_KEY_PREFIX)
+  uint64_t prefix = self->prefixes[a];
+  self->prefixes[a] = self->prefixes[b];
+  self->prefixes[b] = prefix;
+  #endif
+  self->hashes[a]  = self->hashes[b];
+  self->keys[a]    = self->keys[b];
+  self->values[a]  = self->values[b];
+  self->lengths[a] = self->lengths[b];
+  self->hashes[b]  = hash;
+  self->keys[b]    = key;
+  self->values[b]  = value;
+  self->lengths[b] = length;
+}
+
+/**
+ * @brief Doubles the bucket count without a second set of arrays, every entry
+ * is first marked as a tombstone (which free slot searches accept) and is then
+ * placed at the first free slot of its new probe sequence, swapping with the
+ * marked entry found there if any, so placed entries never move again
+ * @param self -> The hash table (no tombstones needed, they are dropped)
+ * @return bool -> Whether the table was large enough to grow in place
+ */
+p_inline bool _table_grow_in_place(EmeraldsTable *self) {
+  size_t i;
+  size_t hash;
+  size_t bucket_index;
+  size_t capacity = self->capacity;
+  #if TABLE_PROBING == TABLE_PROBING_GROUP
+  size_t width = TABLE_GROUP_WIDTH;
+  #else
+  size_t width = 1;
+  #endif
+
+  if(capacity * sizeof(size_t) < TABLE_GROW_IN_PLACE_MIN) {
+    return false;
+  }
+  #if defined(TABLE_PARALLEL_REHASH)
+  /* The redistribution is serial, threaded growth moves into new arrays */
+  if(self->rehash_threads > 1) {
+    return false;
+  }
+  #endif
+  self->keys   = (const char **)_table_extend(
+    self, (void *)self->keys, capacity * sizeof(*self->keys)
+  );
+  self->values = (size_t *)_table_extend(
+    self, self->values, capacity * sizeof(size_t)
+  );
+  self->hashes = (size_t *)_table_extend(
+    self, self->hashes, capacity * sizeof(size_t)
+  );
+  self->lengths = (size_t *)_table_extend(
+    self, self->lengths, capacity * sizeof(size_t)
+  );
+  #if defined(TABLE_KEY_PREFIX)
+  self->prefixes = (uint64_t *)_table_extend(
+    self, self->prefixes, capacity * sizeof(uint64_t)
+  );
+  #endif
+  self->states = (uint8_t *)_table_extend(self, self->states, capacity);
+  memset(self->states + capacity, TABLE_STATE_EMPTY, capacity);
+  self->capacity   = 2 * capacity;
+  self->tombstones = 0;
+
+  for(i = 0; i < capacity; i++) {
+    self->states[i] = TABLE_STATE_IS_FILLED(self->states[i])
+                        ? TABLE_STATE_DELETED
+                        : TABLE_STATE_EMPTY;
+  }
+  for(i = 0; i < capacity; i++) {
+    while(self->states[i] == TABLE_STATE_DELETED) {
+      hash         = TABLE_HASH_AT(self, i);
+      bucket_index = _table_find_free_bucket(self, hash);
+      if((bucket_index & ~(width - 1)) == (i & ~(width - 1))) {
+        self->states[i] = _table_control(hash);
+      } else if(self->states[bucket_index] == TABLE_STATE_EMPTY) {
+        _table_copy_bucket(self, bucket_index, self, i);
+        self->states[bucket_index] = _table_control(hash);
+        self->states[i]            = TABLE_STATE_EMPTY;
+      } else {
+        _table_swap_buckets(self, i, bucket_index);
+        self->states[bucket_index] = _table_control(hash);
+      }
+    }
+  }
+  #if defined(TABLE_OWNED_KEYS)
+  _table_arena_compact(self);
+  #endif
+  return true;
+}
+#endif
+
+#if defined(TABLE_INCREMENTAL_REHASH)
+/**
+ * @brief Starts a gradual rehash, the current arrays become the old generation
+ * and get drained by subsequent operations (finishes any pending one first),
+ * purging tombstones and shrinking go through a new generation as well
+ * @param self -> The hash table
+ * @param capacity_new -> The bucket count of the new generation
+ */
+p_inline void _table_rehash(EmeraldsTable *self, size_t capacity_new) {
+  EmeraldsTable *old;
+  if(self->old != NULL) {
+    _table_migrate(self, self->old->capacity);
+  }
+
+  old = (EmeraldsTable *)_table_allocate(self, sizeof(EmeraldsTable));
+  *old     = *self;
+  old->old = NULL;
+#if defined(TABLE_OWNED_KEYS)
+  memset(&old->arena, 0, sizeof(old->arena));
+#endif
+  /* Prefaulting would pause for the whole generation, migration faults it in */
+  _table_allocate_buckets(self, capacity_new, false);
+  self->tombstones = 0;
+  self->migrated   = 0;
+  self->old        = old;
+}
+#else
+/**
+ * @brief Rehashes into `capacity_new` buckets, the same bucket count purges
+ * the tombstones in place and large tables double in place
+ * @param self -> The hash table
+ * @param capacity_new -> The new bucket count, a power of two
+ */
+p_inline void _table_rehash(EmeraldsTable *self, size_t capacity_new) {
+  if(capacity_new == self->capacity) {
+    _table_purge(self);
+  } else if(capacity_new != 2 * self->capacity || !_table_grow_in_place(self)) {
+    _table_resize(self, capacity_new);
+  }
+}
+#endif
+
+/**
+ * @brief Bucket count to rehash into once the load factor is reached, the
+ * same one when dropping the tombstones brings the load down to half of the
+ * limit, TABLE_GROW_FACTOR times more otherwise
+ * @param self -> The hash table
+ * @return size_t -> The new bucket count
+ */
+p_inline size_t _table_capacity_after_load(EmeraldsTable *self) {
+  size_t capacity_new = self->capacity * TABLE_GROW_FACTOR;
+  if(self->size * 2 <= self->capacity * TABLE_LOAD_FACTOR) {
+    return self->capacity;
+  }
+  return capacity_new < TABLE_INITIAL_SIZE ? TABLE_INITIAL_SIZE : capacity_new;
+}
+
+/**
+ * @brief Shrinks a table whose live entries fill less than
+ * TABLE_SHRINK_LOAD_FACTOR of its buckets, to about twice the room they need
+ * @param self -> The hash table
+ */
+p_inline void _table_shrink_if_sparse(EmeraldsTable *self) {
+  size_t capacity_new;
+  if(self->capacity > TABLE_INITIAL_SIZE &&
+     self->size < self->capacity * TABLE_SHRINK_LOAD_FACTOR) {
+    capacity_new = _table_capacity_for(self->size * 2);
+    if(capacity_new < self->capacity) {
+      _table_rehash(self, capacity_new);
+    }
+  }
+}
+
+EmeraldsTableKey table_key(const char *key) {
+  return table_key_n(key, strlen(key));
+}
+
+EmeraldsTableKey table_key_n(const char *key, size_t keylen) {
+  EmeraldsTableKey handle;
+  handle.key    = key;
+  handle.length = keylen;
+  handle.hash   = TABLE_HASH_FUNCTION(key, keylen);
+  return handle;
+}
+
+void table_init(EmeraldsTable *self) {
+  /* Nothing gets allocated before the first insert */
+  memset(self, 0, sizeof(*self));
+#if defined(TABLE_PARALLEL_REHASH)
+  self->rehash_threads = TABLE_REHASH_THREADS;
+#endif
+}
+
+void table_init_with_allocator(
+  EmeraldsTable *self, const EmeraldsTableAllocator *allocator
+) {
+  table_init(self);
+  self->allocator = allocator;
+}
+
+/**
+ * @brief Initializes an empty table with a given bucket count
+ * @param self -> The hash table
+ * @param capacity -> The bucket count, a power of two
+ */
+p_inline void _table_init_capacity(EmeraldsTable *self, size_t capacity) {
+  table_init(self);
+  _table_allocate_buckets(self, capacity, true);
+}
+
+/**
+ * @brief Inserts or updates a key in the newest generation without checking
+ * the load factor
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param hash -> The hash of the key
+ * @param value -> The value
+ */
+p_inline void _table_insert_hashed(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t hash, size_t value
+) {
+  size_t bucket_index = _table_find_bucket(self, hash, key, keylen, true);
+  if(bucket_index != TABLE_UNDEFINED) {
+    _table_fill_bucket(self, bucket_index, key, keylen, hash, value);
+  }
+}
+
+/**
+ * @brief Inserts a key whose length and hash are already known
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param hash -> The hash of the key
+ * @param value -> The value
+ */
+p_inline void _table_add_hashed(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t hash, size_t value
+) {
+#if defined(TABLE_INCREMENTAL_REHASH)
+  size_t bucket_index;
+#endif
+#if defined(TABLE_OWNED_KEYS)
+  if(_table_arena_is_sparse(self)) {
+    _table_resize(self, self->capacity);
+  }
+#endif
+  if(_table_is_small(self)) {
+    if(_table_small_add(self, key, keylen, hash, value)) {
+      return;
+    }
+    _table_resize(self, _table_capacity_for(self->size + 1));
+  }
+  if(_table_load(self) > self->capacity * TABLE_LOAD_FACTOR) {
+    _table_rehash(self, _table_capacity_after_load(self));
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_migrate(self, TABLE_REHASH_STEP);
+  }
+  if(self->old != NULL) {
+    bucket_index = _table_find_bucket(self->old, hash, key, keylen, false);
+    if(bucket_index != TABLE_UNDEFINED) {
+  #if !defined(TABLE_OWNED_KEYS)
+      _table_set_key(self->old, bucket_index, key, keylen);
+  #endif
+      TABLE_VALUE_AT(self->old, bucket_index) = value;
+      return;
+    }
+  }
+#endif
+  _table_insert_hashed(self, key, keylen, hash, value);
+}
+
+/**
+ * @brief Looks up a key whose length and hash are already known
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param hash -> The hash of the key
+ * @return size_t -> Either the value found or TABLE_UNDEFINED
+ */
+p_inline size_t _table_get_hashed(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t hash
+) {
+  size_t bucket_index;
+  if(_table_is_small(self)) {
+    bucket_index = _table_small_find(self, hash, key, keylen);
+    return bucket_index != TABLE_UNDEFINED ? TABLE_VALUE_AT(self, bucket_index)
+                                           : TABLE_UNDEFINED;
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_migrate(self, TABLE_REHASH_STEP);
+  }
+#endif
+  bucket_index = _table_find_bucket(self, hash, key, keylen, false);
+
+  if(bucket_index != TABLE_UNDEFINED) {
+    return TABLE_VALUE_AT(self, bucket_index);
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    bucket_index = _table_find_bucket(self->old, hash, key, keylen, false);
+    if(bucket_index != TABLE_UNDEFINED) {
+      return TABLE_VALUE_AT(self->old, bucket_index);
+    }
+  }
+#endif
+  return TABLE_UNDEFINED;
+}
+
+/**
+ * @brief Removes a key whose length and hash are already known
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param hash -> The hash of the key
+ */
+p_inline void _table_remove_hashed(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t hash
+) {
+  size_t bucket_index;
+  if(_table_is_small(self)) {
+    bucket_index = _table_small_find(self, hash, key, keylen);
+    if(bucket_index != TABLE_UNDEFINED) {
+#if defined(TABLE_OWNED_KEYS)
+      if(!TABLE_KEY_IS_INLINE(keylen)) {
+        self->arena.garbage += keylen + 1;
+      }
+#endif
+      _table_small_erase(self, bucket_index);
+    }
+    return;
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_migrate(self, TABLE_REHASH_STEP);
+  }
+#endif
+  bucket_index = _table_find_bucket(self, hash, key, keylen, false);
+  if(bucket_index != TABLE_UNDEFINED) {
+#if defined(TABLE_OWNED_KEYS)
+    if(!TABLE_KEY_IS_INLINE(keylen)) {
+      self->arena.garbage += keylen + 1;
+    }
+#endif
+    _table_erase_bucket(self, bucket_index);
+    self->size--;
+    _table_shrink_if_sparse(self);
+    return;
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    bucket_index = _table_find_bucket(self->old, hash, key, keylen, false);
+    if(bucket_index != TABLE_UNDEFINED) {
+  #if defined(TABLE_OWNED_KEYS)
+      if(!TABLE_KEY_IS_INLINE(keylen)) {
+        self->arena.garbage += keylen + 1;
+      }
+  #endif
+      self->old->states[bucket_index] = TABLE_STATE_DELETED;
+      self->old->size--;
+      self->size--;
+      _table_shrink_if_sparse(self);
+    }
+  }
+#endif
+}
+
+void table_add(EmeraldsTable *self, const char *key, size_t value) {
+  table_add_n(self, key, strlen(key), value);
+}
+
+void table_add_n(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t value
+) {
+  _table_add_hashed(
+    self, key, keylen, TABLE_HASH_FUNCTION(key, keylen), value
+  );
+}
+
+void table_add_h(
+  EmeraldsTable *self, const EmeraldsTableKey *key, size_t value
+) {
+  _table_add_hashed(self, key->key, key->length, key->hash, value);
+}
+
+void table_add_batch(
+  EmeraldsTable *self, const char **keys, const size_t *values, size_t n
+) {
+  size_t i;
+  size_t shift;
+  size_t partitions;
+  size_t batch_capacity;
+  size_t capacity_bits = 0;
+  size_t *keylens;
+  size_t *hashes;
+  size_t *order;
+  size_t *offsets;
+
+  /* A batch that still fits the packed entries is simply appended */
+  if(_table_is_small(self) && self->size + n <= TABLE_SMALL_SIZE) {
+    for(i = 0; i < n; i++) {
+      table_add(self, keys[i], values[i]);
+    }
+    return;
+  }
+  keylens = (size_t *)malloc(n * sizeof(size_t));
+  hashes  = (size_t *)malloc(n * sizeof(size_t));
+  order   = (size_t *)malloc(n * sizeof(size_t));
+
+  /* Size once for the larger of the table and the batch, keys that turn out
+   * to be new grow it through the load check, this also drains a pending
+   * migration */
+  batch_capacity = _table_capacity_for(self->size > n ? self->size : n);
+  if(batch_capacity > self->capacity) {
+    _table_resize(self, batch_capacity);
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_migrate(self, self->old->capacity);
+  }
+#endif
+
+  for(i = 0; i < n; i++) {
+    keylens[i] = strlen(keys[i]);
+  }
+  for(i = 0; i < n; i++) {
+    hashes[i] = TABLE_HASH_FUNCTION(keys[i], keylens[i]);
+  }
+
+  /* Stable radix partition on the top bits of the home bucket, so inserts
+   * sweep the bucket arrays front to back instead of scattering */
+  while(((size_t)1 << capacity_bits) < self->capacity) {
+    capacity_bits++;
+  }
+  shift      = capacity_bits > TABLE_BATCH_PARTITION_BITS
+                 ? capacity_bits - TABLE_BATCH_PARTITION_BITS
+                 : 0;
+  partitions = self->capacity >> shift;
+  offsets    = (size_t *)calloc(partitions + 1, sizeof(size_t));
+  for(i = 0; i < n; i++) {
+    offsets[((hashes[i] & (self->capacity - 1)) >> shift) + 1]++;
+  }
+  for(i = 0; i < partitions; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  for(i = 0; i < n; i++) {
+    order[offsets[(hashes[i] & (self->capacity - 1)) >> shift]++] = i;
+  }
+
+  for(i = 0; i < n; i++) {
+    size_t k = order[i];
+    if(_table_load(self) > self->capacity * TABLE_LOAD_FACTOR) {
+      _table_resize(self, _table_capacity_after_load(self));
+    }
+    _table_insert_hashed(self, keys[k], keylens[k], hashes[k], values[k]);
+  }
+
+  free(offsets);
+  free(order);
+  free(hashes);
+  free(keylens);
+}
+
+void table_build_from_arrays(
+  EmeraldsTable *self, const char **keys, const size_t *values, size_t n
+) {
+  _table_init_capacity(self, _table_capacity_for(n));
+  table_add_batch(self, keys, values, n);
+}
+
+void table_add_all(EmeraldsTable *src, EmeraldsTable *dst) {
+  size_t i;
+  for(i = 0; i < src->capacity; i++) {
+    if(TABLE_STATE_IS_FILLED(src->states[i])) {
+      _table_add_hashed(
+        dst,
+        TABLE_KEY_AT(src, i),
+        TABLE_LENGTH_AT(src, i),
+        TABLE_HASH_AT(src, i),
+        TABLE_VALUE_AT(src, i)
+      );
+    }
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(src->old != NULL) {
+    table_add_all(src->old, dst);
+  }
+#endif
+}
+
+void table_add_all_non_labels(EmeraldsTable *src, EmeraldsTable *dst) {
+  size_t i;
+  for(i = 0; i < src->capacity; i++) {
+    if(TABLE_STATE_IS_FILLED(src->states[i])) {
+      const char *key = TABLE_KEY_AT(src, i);
+      size_t keylen   = TABLE_LENGTH_AT(src, i);
+      if(key &&
+         !(keylen >= 3 && key[0] == '@' && key[1] == ':' && key[2] == ':')) {
+        _table_add_hashed(
+          dst, key, keylen, TABLE_HASH_AT(src, i), TABLE_VALUE_AT(src, i)
+        );
+      }
+    }
+  }
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(src->old != NULL) {
+    table_add_all_non_labels(src->old, dst);
+  }
+#endif
+}
+
+size_t table_get(EmeraldsTable *self, const char *key) {
+  return table_get_n(self, key, strlen(key));
+}
+
+size_t table_get_n(EmeraldsTable *self, const char *key, size_t keylen) {
+  return _table_get_hashed(
+    self, key, keylen, TABLE_HASH_FUNCTION(key, keylen)
+  );
+}
+
+size_t table_get_h(EmeraldsTable *self, const EmeraldsTableKey *key) {
+  return _table_get_hashed(self, key->key, key->length, key->hash);
+}
+
+void table_get_batch(
+  EmeraldsTable *self, const char **keys, size_t n, size_t *out
+) {
+  size_t i;
+  size_t j;
+  size_t keylens[TABLE_BATCH_WINDOW];
+  size_t hashes[TABLE_BATCH_WINDOW];
+
+  for(i = 0; i < n; i += TABLE_BATCH_WINDOW) {
+    size_t window = n - i < TABLE_BATCH_WINDOW ? n - i : TABLE_BATCH_WINDOW;
+
+    for(j = 0; j < window; j++) {
+      size_t bucket_index;
+      keylens[j]   = strlen(keys[i + j]);
+      hashes[j]    = TABLE_HASH_FUNCTION(keys[i + j], keylens[j]);
+      bucket_index = hashes[j] & (self->capacity - 1);
+      if(_table_is_small(self)) {
+        continue;
+      }
+      _table_prefetch(&self->states[bucket_index]);
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+      _table_prefetch(&self->slots[bucket_index]);
+#else
+      _table_prefetch(&self->hashes[bucket_index]);
+      _table_prefetch(&self->keys[bucket_index]);
+#endif
+    }
+
+    for(j = 0; j < window; j++) {
+      out[i + j] = _table_get_hashed(self, keys[i + j], keylens[j], hashes[j]);
+    }
+  }
+}
+
+void table_remove(EmeraldsTable *self, const char *key) {
+  table_remove_n(self, key, strlen(key));
+}
+
+void table_remove_n(EmeraldsTable *self, const char *key, size_t keylen) {
+  _table_remove_hashed(self, key, keylen, TABLE_HASH_FUNCTION(key, keylen));
+}
+
+void table_remove_h(EmeraldsTable *self, const EmeraldsTableKey *key) {
+  _table_remove_hashed(self, key->key, key->length, key->hash);
+}
+
+void table_compact(EmeraldsTable *self) {
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_migrate(self, self->old->capacity);
+  }
+#endif
+  _table_purge(self);
+#if defined(TABLE_OWNED_KEYS)
+  _table_arena_compact(self);
+#endif
+}
+
+void table_shrink_to_fit(EmeraldsTable *self) {
+  size_t capacity_new = _table_capacity_for(self->size);
+  if(capacity_new < self->capacity) {
+    _table_resize(self, capacity_new);
+  } else {
+    table_compact(self);
+  }
+}
+
+size_t table_size(EmeraldsTable *self) { return self->size; }
+
+void table_deinit(EmeraldsTable *self) {
+#if defined(TABLE_INCREMENTAL_REHASH)
+  if(self->old != NULL) {
+    _table_free_buckets(self->old);
+    _table_release(self, self->old, sizeof(EmeraldsTable));
+    self->old = NULL;
+  }
+#endif
+#if defined(TABLE_OWNED_KEYS)
+  _table_arena_free(self, &self->arena);
+#endif
+  _table_free_buckets(self);
 }
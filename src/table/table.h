@@ -11,6 +11,29 @@
 
 #define TABLE_GROW_FACTOR (2)
 
+/**
+ * @brief Probing engines selectable at compile time through TABLE_PROBING
+ * TABLE_PROBING_LINEAR -> One bucket at a time, `states` hold FILLED/DELETED
+ * TABLE_PROBING_GROUP  -> Whole groups of control bytes compared at once
+ * (AVX2: 32, SSE2: 16, SWAR: 8), filled control bytes store 7 hash bits
+ * TABLE_PROBING_ROBIN_HOOD -> Clusters kept ordered by home bucket, misses stop
+ * early and removals shift entries back instead of leaving tombstones
+ */
+#define TABLE_PROBING_LINEAR     (0)
+#define TABLE_PROBING_GROUP      (1)
+#define TABLE_PROBING_ROBIN_HOOD (2)
+
+#ifndef TABLE_PROBING
+  #define TABLE_PROBING TABLE_PROBING_LINEAR
+#endif
+
+#if TABLE_PROBING == TABLE_PROBING_GROUP
+  /** @brief High bit marks a filled control byte, low 7 bits the fingerprint */
+  #define TABLE_STATE_IS_FILLED(state) (((state) & 0x80) != 0)
+#else
+  #define TABLE_STATE_IS_FILLED(state) ((state) == TABLE_STATE_FILLED)
+#endif
+
 /** @brief Can dynamically redefine those constants Since values are integers,
  * NULL is not allowed and we define a NaN boxed undefined value */
 #ifndef TABLE_UNDEFINED
@@ -25,42 +48,386 @@
   #define TABLE_INITIAL_SIZE (1 << 10)
 #endif
 
+/**
+ * @brief Removals shrink a table grown past TABLE_INITIAL_SIZE once its live
+ * entries fill less than this share of the buckets, 0 never shrinks
+ */
+#ifndef TABLE_SHRINK_LOAD_FACTOR
+  #define TABLE_SHRINK_LOAD_FACTOR (TABLE_LOAD_FACTOR / 8)
+#endif
+
+/**
+ * @brief Tables of up to this many entries keep them packed in as many
+ * buckets and scan them instead of probing, they move to TABLE_INITIAL_SIZE
+ * hashed buckets once they outgrow it, 0 turns the small mode off
+ */
+#ifndef TABLE_SMALL_SIZE
+  #define TABLE_SMALL_SIZE (8)
+#endif
+
+#if TABLE_SMALL_SIZE >= TABLE_INITIAL_SIZE
+  #error "TABLE_SMALL_SIZE has to stay below TABLE_INITIAL_SIZE"
+#endif
+
+/**
+ * @brief Defining TABLE_INCREMENTAL_REHASH spreads every resize across later
+ * operations, each one migrating TABLE_REHASH_STEP old buckets
+ */
+#ifndef TABLE_REHASH_STEP
+  #define TABLE_REHASH_STEP (32)
+#endif
+
+/**
+ * @brief Incremental rehashes hand the pages of every this many migrated old
+ * buckets back to the kernel on Linux (madvise(MADV_DONTNEED)), so freeing the
+ * drained generation does not unmap all of it within one operation
+ */
+#ifndef TABLE_REHASH_DISCARD
+  #define TABLE_REHASH_DISCARD (1 << 13)
+#endif
+
+/**
+ * @brief Bucket arrays of at least this many bytes get all their pages faulted
+ * in by one madvise(MADV_POPULATE_WRITE) on Linux, instead of one page fault
+ * per page while a resize writes into them
+ */
+#ifndef TABLE_PREFAULT_MIN
+  #define TABLE_PREFAULT_MIN (1 << 20)
+#endif
+
+/**
+ * @brief Split layout linear and group probing tables whose hash array reaches
+ * this many bytes double by extending their arrays in place (realloc, which
+ * moves large blocks by remapping their pages) and redistributing the entries
+ * within them, so growth never holds the old and the new arrays at once
+ * (TABLE_PARALLEL_REHASH tables with more than one `rehash_threads` keep
+ * growing into new arrays)
+ */
+#ifndef TABLE_GROW_IN_PLACE_MIN
+  #define TABLE_GROW_IN_PLACE_MIN ((size_t)1 << 25)
+#endif
+
+/**
+ * @brief Defining TABLE_PARALLEL_REHASH (POSIX threads) splits the growth of
+ * tables with at least TABLE_PARALLEL_REHASH_MIN buckets into chunks of old
+ * home buckets moved by `rehash_threads` threads, Robin Hood stays serial
+ */
+#ifndef TABLE_REHASH_THREADS
+  #define TABLE_REHASH_THREADS (8)
+#endif
+
+#ifndef TABLE_PARALLEL_REHASH_MIN
+  #define TABLE_PARALLEL_REHASH_MIN (1 << 16)
+#endif
+
+/** @brief Number of chunks every rehash thread works through */
+#ifndef TABLE_REHASH_CHUNKS_PER_THREAD
+  #define TABLE_REHASH_CHUNKS_PER_THREAD (4)
+#endif
+
+/**
+ * @brief Defining TABLE_LAYOUT_INTERLEAVED keeps hash, key and value of each
+ * bucket together in one slot, all slots and states share one aligned block
+ */
+#ifndef TABLE_CACHE_LINE_SIZE
+  #define TABLE_CACHE_LINE_SIZE (64)
+#endif
+
+/** @brief Number of keys hashed and prefetched ahead by `table_get_batch` */
+#ifndef TABLE_BATCH_WINDOW
+  #define TABLE_BATCH_WINDOW (16)
+#endif
+
+/**
+ * @brief `table_add_batch` orders inserts into at most 2^bits partitions of
+ * contiguous home buckets
+ */
+#ifndef TABLE_BATCH_PARTITION_BITS
+  #define TABLE_BATCH_PARTITION_BITS (12)
+#endif
+
+/**
+ * @brief Defining TABLE_OWNED_KEYS makes the table copy every new key into a
+ * bump arena of chunks this large (longer keys get a chunk of their own)
+ */
+#ifndef TABLE_ARENA_CHUNK_SIZE
+  #define TABLE_ARENA_CHUNK_SIZE (1 << 16)
+#endif
+
 #ifndef TABLE_HASH_FUNCTION
   #define TABLE_HASH_FUNCTION komihash_hash
 #endif
 
+/**
+ * @brief Defining TABLE_INLINE_KEYS stores keys of up to this many bytes inside
+ * their slot (implies TABLE_LAYOUT_INTERLEAVED), slots are 24 bytes plus the
+ * key buffer: 7 -> 32, 23 -> 48, 39 -> 64 bytes
+ */
+#ifndef TABLE_INLINE_KEY_SIZE
+  #define TABLE_INLINE_KEY_SIZE (23)
+#endif
+
+/**
+ * @brief Defining TABLE_KEY_PREFIX keeps the first 8 bytes of every key in a
+ * parallel array so that keys of up to 8 bytes are verified without touching
+ * them, longer keys are compared past the prefix only
+ */
+#if defined(TABLE_KEY_PREFIX) && \
+  (defined(TABLE_LAYOUT_INTERLEAVED) || defined(TABLE_INLINE_KEYS))
+  #error "TABLE_KEY_PREFIX applies to the split array layout"
+#endif
+
+#if defined(TABLE_INLINE_KEYS) && !defined(TABLE_LAYOUT_INTERLEAVED)
+  #define TABLE_LAYOUT_INTERLEAVED
+#endif
+
+#if defined(TABLE_INLINE_KEYS)
+/**
+ * @brief A single bucket with short keys copied inline, NUL terminated, and
+ * long keys kept behind a pointer
+ * @param hash -> The hash value of the key
+ * @param value -> The value
+ * @param length -> The length of the key, selects the active key member
+ * @param key -> Either the key bytes or a pointer to them
+ */
+typedef struct EmeraldsTableSlot {
+  size_t hash;
+  size_t value;
+  size_t length;
+  union {
+    const char *pointer;
+    char bytes[TABLE_INLINE_KEY_SIZE + 1];
+  } key;
+} EmeraldsTableSlot;
+
+  #define TABLE_KEY_IS_INLINE(length) ((length) <= TABLE_INLINE_KEY_SIZE)
+  #define TABLE_HASH_AT(self, i)      ((self)->slots[(i)].hash)
+  #define TABLE_KEY_AT(self, i)                          \
+    (TABLE_KEY_IS_INLINE((self)->slots[(i)].length)      \
+       ? (const char *)(self)->slots[(i)].key.bytes      \
+       : (self)->slots[(i)].key.pointer)
+  #define TABLE_VALUE_AT(self, i)  ((self)->slots[(i)].value)
+  #define TABLE_LENGTH_AT(self, i) ((self)->slots[(i)].length)
+#elif defined(TABLE_LAYOUT_INTERLEAVED)
+/**
+ * @brief A single bucket, 32 bytes so that two slots share a cache line and no
+ * slot straddles two of them
+ * @param hash -> The hash value of the key
+ * @param key -> The key
+ * @param value -> The value
+ * @param length -> The length of the key
+ */
+typedef struct EmeraldsTableSlot {
+  size_t hash;
+  const char *key;
+  size_t value;
+  size_t length;
+} EmeraldsTableSlot;
+
+  #define TABLE_KEY_IS_INLINE(length) (0)
+  #define TABLE_HASH_AT(self, i)      ((self)->slots[(i)].hash)
+  #define TABLE_KEY_AT(self, i)       ((self)->slots[(i)].key)
+  #define TABLE_VALUE_AT(self, i)  ((self)->slots[(i)].value)
+  #define TABLE_LENGTH_AT(self, i) ((self)->slots[(i)].length)
+#else
+  #define TABLE_KEY_IS_INLINE(length) (0)
+  #define TABLE_HASH_AT(self, i)      ((self)->hashes[(i)])
+  #define TABLE_KEY_AT(self, i)       ((self)->keys[(i)])
+  #define TABLE_VALUE_AT(self, i)  ((self)->values[(i)])
+  #define TABLE_LENGTH_AT(self, i) ((self)->lengths[(i)])
+  #define TABLE_PREFIX_AT(self, i) ((self)->prefixes[(i)])
+#endif
+
+#if defined(TABLE_OWNED_KEYS)
+/**
+ * @brief A block of key bytes, the bytes follow the header
+ * @param prev -> The previously filled chunk
+ * @param capacity -> The number of key bytes the chunk holds
+ */
+typedef struct EmeraldsTableArenaChunk {
+  struct EmeraldsTableArenaChunk *prev;
+  size_t capacity;
+} EmeraldsTableArenaChunk;
+
+/**
+ * @brief Bump allocator for NUL terminated copies of the keys, freed in bulk
+ * @param chunk -> The chunk being filled
+ * @param used -> The bytes used in the current chunk
+ * @param bytes -> The bytes handed out across all chunks
+ * @param garbage -> The bytes of keys that were removed since
+ */
+typedef struct EmeraldsTableArena {
+  EmeraldsTableArenaChunk *chunk;
+  size_t used;
+  size_t bytes;
+  size_t garbage;
+} EmeraldsTableArena;
+#endif
+
+/**
+ * @brief Memory callbacks backing the bucket arrays and the key arena of a
+ * table, sizes are handed back on release so pools need no block headers
+ * @param allocate -> Returns a block of `bytes` bytes
+ * @param reallocate -> Resizes a block of `old_bytes`, keeping its contents
+ * @param release -> Gives back a block of `bytes` bytes
+ * @param context -> Passed to every callback
+ */
+typedef struct EmeraldsTableAllocator {
+  void *(*allocate)(void *context, size_t bytes);
+  void *(*reallocate)(
+    void *context, void *memory, size_t old_bytes, size_t bytes
+  );
+  void (*release)(void *context, void *memory, size_t bytes);
+  void *context;
+} EmeraldsTableAllocator;
+
 /**
  * @brief Data oriented table with open addressing and linear probing
  * @param keys -> The keys of the hash table
  * @param values -> The values of the hash table
  * @param hashes -> The hash values of the keys
- * @param states -> The state of each bucket (empty or filled)
+ * @param lengths -> The lengths of the keys
+ * @param prefixes -> The first 8 bytes of the keys (TABLE_KEY_PREFIX)
+ * @param slots -> Hash, key and value per bucket (interleaved layout)
+ * @param block -> The single allocation backing slots and states
+ * @param states -> The state of each bucket (empty, deleted or filled)
+ * @param capacity -> The number of buckets
  * @param size -> The number of elements in the hash table
  * @param tombstones -> The number of tombstones in the hash table
+ * @param allocator -> The memory callbacks, NULL for malloc and free
+ * @param old -> The generation still being drained by an incremental rehash
+ * @param migrated -> The number of old buckets already migrated
+ * @param arena -> Owns the keys of every generation (TABLE_OWNED_KEYS)
+ * @param rehash_threads -> Threads growing the table (TABLE_PARALLEL_REHASH)
  */
 typedef struct EmeraldsTable {
+#if defined(TABLE_LAYOUT_INTERLEAVED)
+  EmeraldsTableSlot *slots;
+  void *block;
+#else
   const char **keys;
   size_t *values;
   size_t *hashes;
+  size_t *lengths;
+  #if defined(TABLE_KEY_PREFIX)
+  uint64_t *prefixes;
+  #endif
+#endif
   uint8_t *states;
+  size_t capacity;
   size_t size;
   size_t tombstones;
+  const EmeraldsTableAllocator *allocator;
+#if defined(TABLE_INCREMENTAL_REHASH)
+  struct EmeraldsTable *old;
+  size_t migrated;
+#endif
+#if defined(TABLE_OWNED_KEYS)
+  EmeraldsTableArena arena;
+#endif
+#if defined(TABLE_PARALLEL_REHASH)
+  size_t rehash_threads;
+#endif
 } EmeraldsTable;
 
 /**
- * @brief Initializes the hash table
- * @param self
+ * @brief A key hashed once and probed against any number of tables
+ * @param key -> The key
+ * @param length -> The length of the key
+ * @param hash -> The TABLE_HASH_FUNCTION hash of the key
+ */
+typedef struct EmeraldsTableKey {
+  const char *key;
+  size_t length;
+  size_t hash;
+} EmeraldsTableKey;
+
+/**
+ * @brief Precomputes the handle of a NUL terminated key
+ * @param key -> The key
+ * @return EmeraldsTableKey -> The key handle
+ */
+EmeraldsTableKey table_key(const char *key);
+
+/**
+ * @brief Precomputes the handle of a key of known length
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return EmeraldsTableKey -> The key handle
+ */
+EmeraldsTableKey table_key_n(const char *key, size_t keylen);
+
+/**
+ * @brief Initializes an empty hash table without allocating, the buckets get
+ * allocated by the first insert
+ * @param self -> The hash table
  */
 void table_init(EmeraldsTable *self);
 
 /**
- * @brief Inserts a key-value pair into the hash table (open addressing)
+ * @brief Initializes an empty hash table whose storage comes from `allocator`
+ * @param self -> The hash table
+ * @param allocator -> The memory callbacks, has to outlive the table
+ */
+void table_init_with_allocator(
+  EmeraldsTable *self, const EmeraldsTableAllocator *allocator
+);
+
+/**
+ * @brief Inserts a key-value pair into the hash table (open addressing), the
+ * key must outlive the table unless TABLE_OWNED_KEYS makes the table copy it
  * @param self -> The hash table
  * @param key -> The key
  * @param value -> The value
  */
 void table_add(EmeraldsTable *self, const char *key, size_t value);
 
+/**
+ * @brief Inserts a key of known length, the key does not need a NUL terminator
+ * and can point into a larger buffer
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @param value -> The value
+ */
+void table_add_n(
+  EmeraldsTable *self, const char *key, size_t keylen, size_t value
+);
+
+/**
+ * @brief Inserts a precomputed key handle
+ * @param self -> The hash table
+ * @param key -> The key handle
+ * @param value -> The value
+ */
+void table_add_h(
+  EmeraldsTable *self, const EmeraldsTableKey *key, size_t value
+);
+
+/**
+ * @brief Inserts many key-value pairs, the table is sized once for the larger
+ * of itself and the batch (keys already present never grow it), keys are
+ * hashed in one pass and inserted in home bucket order
+ * @param self -> The hash table
+ * @param keys -> The keys
+ * @param values -> The values
+ * @param n -> The number of pairs
+ */
+void table_add_batch(
+  EmeraldsTable *self, const char **keys, const size_t *values, size_t n
+);
+
+/**
+ * @brief Initializes a table sized for `n` pairs and bulk loads them
+ * @param self -> The hash table (uninitialized)
+ * @param keys -> The keys
+ * @param values -> The values
+ * @param n -> The number of pairs
+ */
+void table_build_from_arrays(
+  EmeraldsTable *self, const char **keys, const size_t *values, size_t n
+);
+
 /**
  * @brief Adds all entries from src to dest
  * @param src -> Initial table
@@ -83,6 +450,36 @@ void table_add_all_non_labels(EmeraldsTable *src, EmeraldsTable *dst);
  */
 size_t table_get(EmeraldsTable *self, const char *key);
 
+/**
+ * @brief Linear probing lookup of a key of known length
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t table_get_n(EmeraldsTable *self, const char *key, size_t keylen);
+
+/**
+ * @brief Linear probing lookup of a precomputed key handle
+ * @param self -> The hash table
+ * @param key -> The key handle
+ * @return size_t -> Either the value found or 0xfffc000000000000 if not found
+ */
+size_t table_get_h(EmeraldsTable *self, const EmeraldsTableKey *key);
+
+/**
+ * @brief Looks up many keys at once, a window of keys is hashed and its home
+ * buckets prefetched before any of them is resolved so that cache misses of
+ * independent lookups overlap instead of being paid one after the other
+ * @param self -> The hash table
+ * @param keys -> The keys
+ * @param n -> The number of keys
+ * @param out -> Receives the value (or TABLE_UNDEFINED) of every key
+ */
+void table_get_batch(
+  EmeraldsTable *self, const char **keys, size_t n, size_t *out
+);
+
 /**
  * @brief Removes a key-value pair from the hash table
  * @param self -> The hash table
@@ -90,6 +487,36 @@ size_t table_get(EmeraldsTable *self, const char *key);
  */
 void table_remove(EmeraldsTable *self, const char *key);
 
+/**
+ * @brief Removes a key of known length from the hash table
+ * @param self -> The hash table
+ * @param key -> The key
+ * @param keylen -> The length of the key
+ */
+void table_remove_n(EmeraldsTable *self, const char *key, size_t keylen);
+
+/**
+ * @brief Removes a precomputed key handle from the hash table
+ * @param self -> The hash table
+ * @param key -> The key handle
+ */
+void table_remove_h(EmeraldsTable *self, const EmeraldsTableKey *key);
+
+/**
+ * @brief Drops every tombstone without reallocating the buckets (a pending
+ * incremental rehash is finished first), owned keys are compacted too
+ * @param self -> The hash table
+ */
+void table_compact(EmeraldsTable *self);
+
+/**
+ * @brief Reallocates the buckets to the smallest count that holds the live
+ * entries under the load factor (at least TABLE_INITIAL_SIZE), dropping the
+ * tombstones either way
+ * @param self -> The hash table
+ */
+void table_shrink_to_fit(EmeraldsTable *self);
+
 /**
  * @brief Returns the size of the hash table
  * @param self -> The hash table
@@ -0,0 +1,255 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE
+#endif
+
+#include "table_pages.h"
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+
+  #ifndef MAP_HUGETLB
+    #define MAP_HUGETLB (0x40000)
+  #endif
+  #ifndef MADV_HUGEPAGE
+    #define MADV_HUGEPAGE (14)
+  #endif
+
+  /* The mbind modes of <numaif.h>, so libnuma is not needed */
+  #define TABLE_PAGES_MPOL_BIND       (2)
+  #define TABLE_PAGES_MPOL_INTERLEAVE (3)
+#endif
+
+/**
+ * @brief Rounds a mapping up to whole huge pages
+ * @param bytes -> The requested size
+ * @return size_t -> The mapped size
+ */
+p_inline size_t _table_pages_length(size_t bytes) {
+  return (bytes + TABLE_PAGES_HUGE_SIZE - 1) & ~(TABLE_PAGES_HUGE_SIZE - 1);
+}
+
+#if defined(__linux__)
+/**
+ * @brief Maps anonymous memory starting on a huge page boundary, since
+ * transparent huge pages only back aligned 2 MB ranges
+ * @param length -> The size, a multiple of TABLE_PAGES_HUGE_SIZE
+ * @return void * -> The mapping, MAP_FAILED on failure
+ */
+p_inline void *_table_pages_map_aligned(size_t length) {
+  size_t mapped = length + TABLE_PAGES_HUGE_SIZE;
+  size_t head;
+  size_t tail;
+  char *memory = (char *)mmap(
+    NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+  );
+
+  if(memory == (char *)MAP_FAILED) {
+    return MAP_FAILED;
+  }
+  head = (size_t)memory & (TABLE_PAGES_HUGE_SIZE - 1);
+  head = head > 0 ? TABLE_PAGES_HUGE_SIZE - head : 0;
+  tail = mapped - head - length;
+  if(head > 0) {
+    munmap(memory, head);
+  }
+  if(tail > 0) {
+    munmap(memory + head + length, tail);
+  }
+  return memory + head;
+}
+
+/**
+ * @brief Applies the NUMA placement to a fresh mapping, before any page of it
+ * has been touched
+ * @param self -> The page settings
+ * @param memory -> The mapping
+ * @param length -> The mapped size
+ */
+p_inline void
+_table_pages_place(EmeraldsTablePages *self, void *memory, size_t length) {
+  long mode;
+  if(self->numa_policy == TABLE_PAGES_NUMA_LOCAL) {
+    return;
+  }
+  mode = self->numa_policy == TABLE_PAGES_NUMA_BIND
+           ? TABLE_PAGES_MPOL_BIND
+           : TABLE_PAGES_MPOL_INTERLEAVE;
+  /* The kernel reads one bit less than maxnode */
+  if(syscall(
+       SYS_mbind,
+       memory,
+       length,
+       mode,
+       &self->numa_nodes,
+       8 * sizeof(self->numa_nodes) + 1,
+       0
+     ) != 0) {
+    self->numa_fallbacks++;
+  }
+}
+#endif
+
+/**
+ * @brief Maps large blocks on huge pages, mallocs the rest
+ * @param context -> The page settings
+ * @param bytes -> The requested size
+ * @return void * -> The block
+ */
+static void *_table_pages_allocate(void *context, size_t bytes) {
+#if defined(__linux__)
+  EmeraldsTablePages *self = (EmeraldsTablePages *)context;
+  size_t length            = _table_pages_length(bytes);
+  void *memory             = MAP_FAILED;
+
+  if(bytes < TABLE_PAGES_MIN) {
+    return malloc(bytes);
+  }
+  if(self->hugetlb) {
+    memory = mmap(
+      NULL,
+      length,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+      -1,
+      0
+    );
+    if(memory == MAP_FAILED) {
+      self->hugetlb_fallbacks++;
+    }
+  }
+  if(memory == MAP_FAILED) {
+    memory = _table_pages_map_aligned(length);
+    if(memory == MAP_FAILED) {
+      return NULL;
+    }
+    madvise(memory, length, MADV_HUGEPAGE);
+  }
+  _table_pages_place(self, memory, length);
+  self->mapped += length;
+  return memory;
+#else
+  (void)context;
+  return malloc(bytes);
+#endif
+}
+
+/**
+ * @brief Unmaps large blocks, frees the rest
+ * @param context -> The page settings
+ * @param memory -> The block
+ * @param bytes -> The size it was requested with
+ */
+static void _table_pages_release(void *context, void *memory, size_t bytes) {
+#if defined(__linux__)
+  EmeraldsTablePages *self = (EmeraldsTablePages *)context;
+  if(bytes >= TABLE_PAGES_MIN) {
+    munmap(memory, _table_pages_length(bytes));
+    self->mapped -= _table_pages_length(bytes);
+    return;
+  }
+#else
+  (void)context;
+  (void)bytes;
+#endif
+  free(memory);
+}
+
+#if defined(__linux__)
+/**
+ * @brief Resizes a mapping by moving its pages instead of their contents,
+ * growth lands on a fresh aligned range so huge pages stay possible
+ * @param self -> The page settings
+ * @param memory -> The mapping
+ * @param old_length -> Its mapped size
+ * @param length -> The new mapped size
+ * @return void * -> The mapping, MAP_FAILED when the kernel refuses
+ */
+p_inline void *_table_pages_remap(
+  EmeraldsTablePages *self, void *memory, size_t old_length, size_t length
+) {
+  void *target;
+  if(length <= old_length) {
+    memory = mremap(memory, old_length, length, 0);
+  } else {
+    target = _table_pages_map_aligned(length);
+    if(target == MAP_FAILED) {
+      return MAP_FAILED;
+    }
+    memory = mremap(
+      memory, old_length, length, MREMAP_MAYMOVE | MREMAP_FIXED, target
+    );
+    if(memory == MAP_FAILED) {
+      munmap(target, length);
+      return MAP_FAILED;
+    }
+    madvise(memory, length, MADV_HUGEPAGE);
+    _table_pages_place(self, memory, length);
+  }
+  if(memory != MAP_FAILED) {
+    self->mapped += length;
+    self->mapped -= old_length;
+  }
+  return memory;
+}
+#endif
+
+/**
+ * @brief Remaps blocks that stay large on Linux, moves the others (off Linux
+ * every block is a malloc block)
+ * @param context -> The page settings
+ * @param memory -> The block
+ * @param old_bytes -> The size it was requested with
+ * @param bytes -> The new size
+ * @return void * -> The block holding the contents
+ */
+static void *_table_pages_reallocate(
+  void *context, void *memory, size_t old_bytes, size_t bytes
+) {
+#if defined(__linux__)
+  void *moved;
+  if(old_bytes >= TABLE_PAGES_MIN && bytes >= TABLE_PAGES_MIN) {
+    moved = _table_pages_remap(
+      (EmeraldsTablePages *)context,
+      memory,
+      _table_pages_length(old_bytes),
+      _table_pages_length(bytes)
+    );
+    if(moved != MAP_FAILED) {
+      return moved;
+    }
+  }
+  moved = _table_pages_allocate(context, bytes);
+  if(moved != NULL) {
+    memcpy(moved, memory, old_bytes < bytes ? old_bytes : bytes);
+    _table_pages_release(context, memory, old_bytes);
+  }
+  return moved;
+#else
+  (void)context;
+  (void)old_bytes;
+  return realloc(memory, bytes);
+#endif
+}
+
+void table_pages_init(EmeraldsTablePages *self, bool hugetlb) {
+  memset(self, 0, sizeof(*self));
+  self->hugetlb              = hugetlb;
+  self->numa_policy          = TABLE_PAGES_NUMA_LOCAL;
+  self->allocator.allocate   = _table_pages_allocate;
+  self->allocator.reallocate = _table_pages_reallocate;
+  self->allocator.release    = _table_pages_release;
+  self->allocator.context    = self;
+}
+
+void table_pages_numa(
+  EmeraldsTablePages *self, int policy, unsigned long nodes
+) {
+  self->numa_policy = policy;
+  self->numa_nodes  = nodes;
+}
+
+const EmeraldsTableAllocator *table_pages_allocator(EmeraldsTablePages *self) {
+  return &self->allocator;
+}
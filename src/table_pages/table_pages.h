@@ -0,0 +1,72 @@
+#ifndef __TABLE_PAGES_H_
+#define __TABLE_PAGES_H_
+
+#include "../table/table.h"
+
+/** @brief Blocks of at least this many bytes get mapped, smaller ones malloc */
+#ifndef TABLE_PAGES_MIN
+  #define TABLE_PAGES_MIN ((size_t)1 << 21)
+#endif
+
+/** @brief The huge page size mappings are aligned to and rounded up to */
+#ifndef TABLE_PAGES_HUGE_SIZE
+  #define TABLE_PAGES_HUGE_SIZE ((size_t)1 << 21)
+#endif
+
+/** @brief NUMA placement, the kernel default of the node touching first */
+#define TABLE_PAGES_NUMA_LOCAL (0)
+/** @brief NUMA placement, only on the given nodes */
+#define TABLE_PAGES_NUMA_BIND (1)
+/** @brief NUMA placement, pages spread round robin over the given nodes */
+#define TABLE_PAGES_NUMA_INTERLEAVE (2)
+
+/**
+ * @brief Allocator mapping large table storage on 2 MB pages on Linux, either
+ * from the hugetlb pool or as transparent huge pages, and optionally placing
+ * it on a set of NUMA nodes (elsewhere everything falls back to malloc)
+ * @param hugetlb -> Tries MAP_HUGETLB before transparent huge pages
+ * @param numa_policy -> One of the TABLE_PAGES_NUMA_ placements
+ * @param numa_nodes -> The node mask of the placement, bit n is node n
+ * @param mapped -> The bytes currently mapped for tables
+ * @param hugetlb_fallbacks -> The mappings the hugetlb pool could not serve
+ * @param numa_fallbacks -> The mappings the kernel refused to place
+ * @param allocator -> The callbacks mapping through these settings
+ */
+typedef struct EmeraldsTablePages {
+  bool hugetlb;
+  int numa_policy;
+  unsigned long numa_nodes;
+  size_t mapped;
+  size_t hugetlb_fallbacks;
+  size_t numa_fallbacks;
+  EmeraldsTableAllocator allocator;
+} EmeraldsTablePages;
+
+/**
+ * @brief Initializes huge page placement with the local NUMA policy, the
+ * counters are only exact while a single thread allocates through it
+ * @param self -> The page settings
+ * @param hugetlb -> Reserves from the hugetlb pool first, which needs pages
+ * set aside in /proc/sys/vm/nr_hugepages, otherwise asks for transparent huge
+ * pages with madvise(MADV_HUGEPAGE)
+ */
+void table_pages_init(EmeraldsTablePages *self, bool hugetlb);
+
+/**
+ * @brief Sets the NUMA placement of later mappings
+ * @param self -> The page settings
+ * @param policy -> One of the TABLE_PAGES_NUMA_ placements
+ * @param nodes -> The node mask, ignored for TABLE_PAGES_NUMA_LOCAL
+ */
+void table_pages_numa(
+  EmeraldsTablePages *self, int policy, unsigned long nodes
+);
+
+/**
+ * @brief The allocator to initialize tables with, valid as long as self
+ * @param self -> The page settings
+ * @return const EmeraldsTableAllocator * -> The allocator
+ */
+const EmeraldsTableAllocator *table_pages_allocator(EmeraldsTablePages *self);
+
+#endif
@@ -0,0 +1,127 @@
+#include "table_pool.h"
+
+/**
+ * @brief Maps a request to its size class
+ * @param bytes -> The requested size
+ * @param class_bytes -> Receives the size of the blocks of the class
+ * @return size_t -> The class, TABLE_POOL_CLASSES for blocks that bypass
+ */
+p_inline size_t _table_pool_class(size_t bytes, size_t *class_bytes) {
+  size_t step;
+  size_t steps;
+  size_t shift = TABLE_POOL_MIN_SHIFT;
+
+  *class_bytes = bytes;
+  if(bytes <= (size_t)1 << shift) {
+    *class_bytes = (size_t)1 << shift;
+    return 0;
+  }
+  while(((size_t)1 << (shift + 1)) < bytes) {
+    shift++;
+  }
+  if(shift >= TABLE_POOL_MAX_SHIFT) {
+    return TABLE_POOL_CLASSES;
+  }
+
+  /* 2^shift < bytes <= 2^(shift + 1), in steps of a quarter */
+  step         = (size_t)1 << (shift - 2);
+  steps        = (bytes - ((size_t)1 << shift) + step - 1) >> (shift - 2);
+  *class_bytes = ((size_t)1 << shift) + steps * step;
+  return 4 * (shift - TABLE_POOL_MIN_SHIFT) + steps;
+}
+
+/**
+ * @brief Takes a cached block of the class or a new one from the system
+ * @param context -> The pool
+ * @param bytes -> The requested size
+ * @return void * -> The block
+ */
+static void *_table_pool_allocate(void *context, size_t bytes) {
+  EmeraldsTablePool *self = (EmeraldsTablePool *)context;
+  size_t class_bytes;
+  size_t size_class = _table_pool_class(bytes, &class_bytes);
+  void *memory;
+
+  if(size_class < TABLE_POOL_CLASSES && self->free_lists[size_class]) {
+    memory                       = self->free_lists[size_class];
+    self->free_lists[size_class] = *(void **)memory;
+    self->cached -= class_bytes;
+    return memory;
+  }
+  self->misses++;
+  return malloc(class_bytes);
+}
+
+/**
+ * @brief Caches a block for its class, or frees it past the limit
+ * @param context -> The pool
+ * @param memory -> The block
+ * @param bytes -> The size it was requested with
+ */
+static void _table_pool_release(void *context, void *memory, size_t bytes) {
+  EmeraldsTablePool *self = (EmeraldsTablePool *)context;
+  size_t class_bytes;
+  size_t size_class = _table_pool_class(bytes, &class_bytes);
+
+  if(size_class == TABLE_POOL_CLASSES ||
+     self->cached + class_bytes > self->limit) {
+    free(memory);
+    return;
+  }
+  *(void **)memory             = self->free_lists[size_class];
+  self->free_lists[size_class] = memory;
+  self->cached += class_bytes;
+}
+
+/**
+ * @brief Keeps blocks that stay in their class, moves the others
+ * @param context -> The pool
+ * @param memory -> The block
+ * @param old_bytes -> The size it was requested with
+ * @param bytes -> The new size
+ * @return void * -> The block holding the contents
+ */
+static void *_table_pool_reallocate(
+  void *context, void *memory, size_t old_bytes, size_t bytes
+) {
+  size_t old_class_bytes;
+  size_t class_bytes;
+  size_t old_class = _table_pool_class(old_bytes, &old_class_bytes);
+  size_t new_class = _table_pool_class(bytes, &class_bytes);
+  void *moved;
+
+  if(old_class == new_class && old_class < TABLE_POOL_CLASSES) {
+    return memory;
+  }
+  moved = _table_pool_allocate(context, bytes);
+  memcpy(moved, memory, old_bytes < bytes ? old_bytes : bytes);
+  _table_pool_release(context, memory, old_bytes);
+  return moved;
+}
+
+void table_pool_init(EmeraldsTablePool *self, size_t limit) {
+  memset(self, 0, sizeof(*self));
+  self->limit                = limit ? limit : TABLE_POOL_DEFAULT_LIMIT;
+  self->allocator.allocate   = _table_pool_allocate;
+  self->allocator.reallocate = _table_pool_reallocate;
+  self->allocator.release    = _table_pool_release;
+  self->allocator.context    = self;
+}
+
+const EmeraldsTableAllocator *table_pool_allocator(EmeraldsTablePool *self) {
+  return &self->allocator;
+}
+
+void table_pool_trim(EmeraldsTablePool *self) {
+  size_t i;
+  for(i = 0; i < TABLE_POOL_CLASSES; i++) {
+    while(self->free_lists[i] != NULL) {
+      void *next = *(void **)self->free_lists[i];
+      free(self->free_lists[i]);
+      self->free_lists[i] = next;
+    }
+  }
+  self->cached = 0;
+}
+
+void table_pool_deinit(EmeraldsTablePool *self) { table_pool_trim(self); }
@@ -0,0 +1,74 @@
+#ifndef __TABLE_POOL_H_
+#define __TABLE_POOL_H_
+
+#include "../table/table.h"
+
+/** @brief Smallest block the pool hands out, as a power of two */
+#ifndef TABLE_POOL_MIN_SHIFT
+  #define TABLE_POOL_MIN_SHIFT (6)
+#endif
+
+/** @brief Blocks larger than 2^TABLE_POOL_MAX_SHIFT bytes bypass the pool */
+#ifndef TABLE_POOL_MAX_SHIFT
+  #define TABLE_POOL_MAX_SHIFT (26)
+#endif
+
+/** @brief Default bytes a pool keeps cached before releasing to the system */
+#ifndef TABLE_POOL_DEFAULT_LIMIT
+  #define TABLE_POOL_DEFAULT_LIMIT ((size_t)1 << 26)
+#endif
+
+/**
+ * @brief Every power of two range is split into four size classes, so
+ * rounding up wastes at most a fifth of a block
+ */
+#define TABLE_POOL_CLASSES \
+  (4 * (TABLE_POOL_MAX_SHIFT - TABLE_POOL_MIN_SHIFT) + 1)
+
+/**
+ * @brief Size class cache of released table storage, a block given back by
+ * one table is handed to the next one asking for the same class (a pool is
+ * not thread safe, use one per thread or per request)
+ * @param free_lists -> The cached blocks of each class, linked through their
+ * first word
+ * @param cached -> The bytes held by the free lists
+ * @param limit -> Releases past this many cached bytes go to the system
+ * @param misses -> The blocks that had to come from the system allocator
+ * @param allocator -> The callbacks drawing from this pool
+ */
+typedef struct EmeraldsTablePool {
+  void *free_lists[TABLE_POOL_CLASSES];
+  size_t cached;
+  size_t limit;
+  size_t misses;
+  EmeraldsTableAllocator allocator;
+} EmeraldsTablePool;
+
+/**
+ * @brief Initializes an empty pool
+ * @param self -> The pool
+ * @param limit -> The most bytes kept cached, TABLE_POOL_DEFAULT_LIMIT for 0
+ */
+void table_pool_init(EmeraldsTablePool *self, size_t limit);
+
+/**
+ * @brief The allocator to initialize tables with, valid as long as the pool
+ * @param self -> The pool
+ * @return const EmeraldsTableAllocator * -> The allocator
+ */
+const EmeraldsTableAllocator *table_pool_allocator(EmeraldsTablePool *self);
+
+/**
+ * @brief Releases every cached block to the system
+ * @param self -> The pool
+ */
+void table_pool_trim(EmeraldsTablePool *self);
+
+/**
+ * @brief Releases the cached blocks, every table using the pool has to be
+ * deinitialized first
+ * @param self -> The pool
+ */
+void table_pool_deinit(EmeraldsTablePool *self);
+
+#endif
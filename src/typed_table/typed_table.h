@@ -0,0 +1,178 @@
+#ifndef __TYPED_TABLE_H_
+#define __TYPED_TABLE_H_
+
+#include "../../libs/EmeraldsBool/export/EmeraldsBool.h"
+#include "../../libs/EmeraldsVector/export/EmeraldsVector.h"
+#include "../table/table.h"
+
+/**
+ * @brief Generates a fully specialized open addressing table type `T` with
+ * functions prefixed by `prefix`, using the global load factor and size
+ * @param T -> The name of the generated table type
+ * @param prefix -> The prefix of the generated functions
+ * @param K -> The key type
+ * @param V -> The value type
+ * @param hash_fn -> `size_t hash_fn(K key)`, a function or macro
+ * @param eq_fn -> `bool eq_fn(K a, K b)`, a function or macro
+ */
+#define TABLE_DEFINE(T, prefix, K, V, hash_fn, eq_fn) \
+  TABLE_DEFINE_TUNED(                                 \
+    T,                                                \
+    prefix,                                           \
+    K,                                                \
+    V,                                                \
+    hash_fn,                                          \
+    eq_fn,                                            \
+    TABLE_LOAD_FACTOR,                                \
+    TABLE_INITIAL_SIZE                                \
+  )
+
+/**
+ * @brief Same as TABLE_DEFINE with a table specific load factor and initial
+ * bucket count (a power of two). Tombstones count toward the load factor,
+ * which is capped so one bucket always stays empty, a full table whose live
+ * keys take at most half of it is rebuilt at the same bucket count instead of
+ * growing. Generates:
+ * void prefix_init(T *self)
+ * void prefix_add(T *self, K key, V value)
+ * V *prefix_get(T *self, K key) -> NULL when the key is missing
+ * bool prefix_remove(T *self, K key)
+ * size_t prefix_size(T *self)
+ * void prefix_deinit(T *self)
+ * The invocation is terminated with a semicolon like any declaration.
+ */
+#define TABLE_DEFINE_TUNED(                                                  \
+  T, prefix, K, V, hash_fn, eq_fn, load_factor, initial_size                 \
+)                                                                            \
+  typedef struct T {                                                         \
+    K *keys;                                                                 \
+    V *values;                                                               \
+    uint8_t *states;                                                         \
+    size_t capacity;                                                         \
+    size_t size;                                                             \
+    size_t tombstones;                                                       \
+  } T;                                                                       \
+                                                                             \
+  p_inline size_t _##prefix##_find_bucket(                                   \
+    T *self, K key, bool find_empty                                          \
+  ) {                                                                        \
+    size_t i;                                                                \
+    size_t mask          = self->capacity - 1;                               \
+    size_t bucket_index  = (size_t)(hash_fn(key)) & mask;                    \
+    size_t first_deleted = TABLE_UNDEFINED;                                  \
+                                                                             \
+    for(i = 0; i <= mask; i++) {                                             \
+      if(self->states[bucket_index] == TABLE_STATE_EMPTY) {                  \
+        if(!find_empty) {                                                    \
+          return TABLE_UNDEFINED;                                            \
+        }                                                                    \
+        return first_deleted != TABLE_UNDEFINED ? first_deleted              \
+                                                : bucket_index;              \
+      } else if(self->states[bucket_index] == TABLE_STATE_DELETED) {         \
+        if(find_empty && first_deleted == TABLE_UNDEFINED) {                 \
+          first_deleted = bucket_index;                                      \
+        }                                                                    \
+      } else if(eq_fn(self->keys[bucket_index], key)) {                      \
+        return bucket_index;                                                 \
+      }                                                                      \
+      bucket_index = (bucket_index + 1) & mask;                              \
+    }                                                                        \
+                                                                             \
+    return find_empty ? first_deleted : TABLE_UNDEFINED;                     \
+  }                                                                          \
+                                                                             \
+  p_inline void _##prefix##_allocate(T *self, size_t capacity) {             \
+    vector_initialize_n(self->keys, capacity);                               \
+    vector_initialize_n(self->values, capacity);                             \
+    vector_initialize_n(self->states, capacity);                             \
+    self->capacity   = capacity;                                             \
+    self->tombstones = 0;                                                    \
+  }                                                                          \
+                                                                             \
+  p_inline void prefix##_deinit(T *self) {                                   \
+    vector_free(self->keys);                                                 \
+    vector_free(self->values);                                               \
+    vector_free(self->states);                                               \
+  }                                                                          \
+                                                                             \
+  p_inline void _##prefix##_rehash(T *self, size_t capacity_new) {           \
+    size_t i;                                                                \
+    T new_table = *self;                                                     \
+    _##prefix##_allocate(&new_table, capacity_new);                          \
+    for(i = 0; i < self->capacity; i++) {                                    \
+      if(self->states[i] == TABLE_STATE_FILLED) {                            \
+        size_t mask         = new_table.capacity - 1;                        \
+        size_t bucket_index = (size_t)(hash_fn(self->keys[i])) & mask;       \
+        while(new_table.states[bucket_index] == TABLE_STATE_FILLED) {        \
+          bucket_index = (bucket_index + 1) & mask;                          \
+        }                                                                    \
+        new_table.keys[bucket_index]   = self->keys[i];                      \
+        new_table.values[bucket_index] = self->values[i];                    \
+        new_table.states[bucket_index] = TABLE_STATE_FILLED;                 \
+      }                                                                      \
+    }                                                                        \
+    prefix##_deinit(self);                                                   \
+    *self = new_table;                                                       \
+  }                                                                          \
+                                                                             \
+  p_inline void prefix##_init(T *self) {                                     \
+    _##prefix##_allocate(self, (initial_size));                              \
+    self->size = 0;                                                          \
+  }                                                                          \
+                                                                             \
+  /* The load limit, never the last empty bucket since it ends every probe */\
+  p_inline double _##prefix##_limit(T *self) {                               \
+    double limit = self->capacity * (load_factor);                           \
+    return limit < self->capacity - 1 ? limit : self->capacity - 1;          \
+  }                                                                          \
+                                                                             \
+  p_inline void prefix##_add(T *self, K key, V value) {                      \
+    size_t bucket_index;                                                     \
+    if(self->size + self->tombstones + 1 > _##prefix##_limit(self)) {        \
+      /* Mostly tombstones, rebuilding at the same size is enough */         \
+      _##prefix##_rehash(                                                    \
+        self,                                                                \
+        self->size * 2 <= _##prefix##_limit(self)                            \
+          ? self->capacity                                                   \
+          : self->capacity * TABLE_GROW_FACTOR                               \
+      );                                                                     \
+    }                                                                        \
+    bucket_index = _##prefix##_find_bucket(self, key, true);                 \
+    if(bucket_index == TABLE_UNDEFINED) {                                    \
+      _##prefix##_rehash(self, self->capacity * TABLE_GROW_FACTOR);          \
+      bucket_index = _##prefix##_find_bucket(self, key, true);               \
+    }                                                                        \
+    if(self->states[bucket_index] != TABLE_STATE_FILLED) {                   \
+      if(self->states[bucket_index] == TABLE_STATE_DELETED) {                \
+        self->tombstones--;                                                  \
+      }                                                                      \
+      self->states[bucket_index] = TABLE_STATE_FILLED;                       \
+      self->keys[bucket_index]   = key;                                      \
+      self->size++;                                                          \
+    }                                                                        \
+    self->values[bucket_index] = value;                                      \
+  }                                                                          \
+                                                                             \
+  p_inline V *prefix##_get(T *self, K key) {                                 \
+    size_t bucket_index = _##prefix##_find_bucket(self, key, false);         \
+    return bucket_index == TABLE_UNDEFINED ? NULL                            \
+                                           : &self->values[bucket_index];    \
+  }                                                                          \
+                                                                             \
+  p_inline bool prefix##_remove(T *self, K key) {                            \
+    size_t bucket_index = _##prefix##_find_bucket(self, key, false);         \
+    if(bucket_index == TABLE_UNDEFINED) {                                    \
+      return false;                                                          \
+    }                                                                        \
+    self->states[bucket_index] = TABLE_STATE_DELETED;                        \
+    self->size--;                                                            \
+    self->tombstones++;                                                      \
+    return true;                                                             \
+  }                                                                          \
+                                                                             \
+  p_inline size_t prefix##_size(T *self) { return self->size; }            \
+                                                                             \
+  /* Redeclaration so that call sites end the macro with a semicolon */      \
+  p_inline size_t prefix##_size(T *self)
+
+#endif